@@ -0,0 +1,546 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2024 Osama Salah-ud-din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "coapServer.hpp"
+#include "sensorManager.hpp"
+#include "socketManager.hpp"
+#include "myLogger.hpp"
+
+#include <zephyr/sys/util.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+/* COAP_WELL_KNOWN_CORE_PATH is a C compound literal, spell it out for C++ */
+static const char* const well_known_core_path[] = {".well-known", "core", nullptr};
+
+coapServer& coapServer::getInstance()
+{
+    static coapServer instance;
+    return instance;
+}
+
+coapServer::coapServer()
+{
+    k_mutex_init(&lock);
+    memset(slots, 0, sizeof(slots));
+    memset(resources, 0, sizeof(resources));
+    memset(observers, 0, sizeof(observers));
+    memset(observer_state, 0, sizeof(observer_state));
+    k_work_init_delayable(&con_work, conTimeout);
+}
+
+bool coapServer::init()
+{
+    k_mutex_lock(&lock, K_FOREVER);
+
+    if (is_initialized)
+    {
+        k_mutex_unlock(&lock);
+        return true;
+    }
+
+    /* Resource table: .well-known/core, then value and history per sensor, then a terminator */
+    sensorManager& sensors = sensorManager::getInstance();
+    size_t         r       = 0;
+
+    resources[r].get  = wellKnownGet;
+    resources[r].path = well_known_core_path;
+    r++;
+
+    for (size_t i = 0; (i < sensors.sensor_count()) && (slot_count < MAX_SENSORS); i++)
+    {
+        sensorSlot& slot = slots[slot_count++];
+
+        slot.source          = sensors.get_sensor(i);
+        slot.value_path[0]   = "sensors";
+        slot.value_path[1]   = slot.source->get_id();
+        slot.value_path[2]   = nullptr;
+        slot.history_path[0] = "sensors";
+        slot.history_path[1] = slot.source->get_id();
+        slot.history_path[2] = "history";
+        slot.history_path[3] = nullptr;
+
+        resources[r].get       = valueGet;
+        resources[r].notify    = valueNotify;
+        resources[r].path      = slot.value_path;
+        resources[r].user_data = &slot;
+        r++;
+
+        resources[r].get       = historyGet;
+        resources[r].path      = slot.history_path;
+        resources[r].user_data = &slot;
+        r++;
+    }
+
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0)
+    {
+        MYLOG("❌ CoAP socket failed: %d", errno);
+        k_mutex_unlock(&lock);
+        return false;
+    }
+
+    struct sockaddr_in local = {};
+    local.sin_family         = AF_INET;
+    local.sin_port           = htons(CONFIG_APP_COAP_PORT);
+
+    if (bind(sock, (struct sockaddr*)&local, sizeof(local)) < 0)
+    {
+        MYLOG("❌ CoAP bind to port %d failed: %d", CONFIG_APP_COAP_PORT, errno);
+        close(sock);
+        sock = -1;
+        k_mutex_unlock(&lock);
+        return false;
+    }
+
+    is_initialized = true;
+    k_mutex_unlock(&lock);
+
+    /* Requests are served on the socketManager network thread */
+    if (!socketManager::getInstance().watchFd(sock, onReadable, this))
+    {
+        return false;
+    }
+
+    MYLOG("✅ CoAP server on port %d with %u sensors", CONFIG_APP_COAP_PORT, slot_count);
+    return true;
+}
+
+void coapServer::publish(const sensor* source, float value, int64_t epoch_us)
+{
+    k_mutex_lock(&lock, K_FOREVER);
+
+    for (size_t i = 0; i < slot_count; i++)
+    {
+        sensorSlot& slot = slots[i];
+        if (slot.source != source)
+        {
+            continue;
+        }
+
+        slot.history[slot.head] = {epoch_us, value};
+        slot.head               = (slot.head + 1) % HISTORY_LEN;
+        slot.count              = MIN(slot.count + 1, HISTORY_LEN);
+        slot.total++;
+
+        /* Quiet unless someone observes this sensor */
+        struct coap_resource* resource = &resources[1 + (2 * i)];
+        if (!sys_slist_is_empty(&resource->observers))
+        {
+            coap_resource_notify(resource);
+        }
+        break;
+    }
+
+    k_mutex_unlock(&lock);
+}
+
+void coapServer::onReadable(int fd, void* ctx)
+{
+    ARG_UNUSED(fd);
+    static_cast<coapServer*>(ctx)->handleDatagram();
+}
+
+void coapServer::handleDatagram()
+{
+    uint8_t            buf[MAX_MSG_LEN];
+    struct sockaddr    addr;
+    socklen_t          addr_len = sizeof(addr);
+    struct coap_packet request;
+    struct coap_option options[MAX_OPTIONS];
+
+    ssize_t len = recvfrom(sock, buf, sizeof(buf), MSG_DONTWAIT, &addr, &addr_len);
+    if (len <= 0)
+    {
+        return;
+    }
+
+    if (coap_packet_parse(&request, buf, len, options, MAX_OPTIONS) < 0)
+    {
+        return;
+    }
+
+    k_mutex_lock(&lock, K_FOREVER);
+
+    if (coap_header_get_type(&request) == COAP_TYPE_RESET)
+    {
+        handleReset(request, addr);
+        k_mutex_unlock(&lock);
+        return;
+    }
+
+    if (coap_header_get_type(&request) == COAP_TYPE_ACK)
+    {
+        handleAck(request);
+        k_mutex_unlock(&lock);
+        return;
+    }
+
+    int ret = coap_handle_request(&request, resources, options, MAX_OPTIONS, &addr, addr_len);
+    if ((ret == -ENOENT) || (ret == -EPERM))
+    {
+        uint8_t            data[MAX_MSG_LEN];
+        struct coap_packet response;
+        uint8_t            token[COAP_TOKEN_MAX_LEN];
+        uint8_t            tkl  = coap_header_get_token(&request, token);
+        bool               con  = (coap_header_get_type(&request) == COAP_TYPE_CON);
+        uint8_t            code = (ret == -ENOENT) ? COAP_RESPONSE_CODE_NOT_FOUND : COAP_RESPONSE_CODE_NOT_ALLOWED;
+
+        if (coap_packet_init(&response, data, sizeof(data), COAP_VERSION_1, con ? COAP_TYPE_ACK : COAP_TYPE_NON_CON,
+                             tkl, token, code, con ? coap_header_get_id(&request) : coap_next_id()) == 0)
+        {
+            reply(response, &addr, addr_len);
+        }
+    }
+
+    k_mutex_unlock(&lock);
+}
+
+void coapServer::handleReset(const struct coap_packet& request, const struct sockaddr& addr)
+{
+    ARG_UNUSED(request);
+
+    /* RST to a notification means the client lost interest (RFC 7641, 3.6) */
+    struct coap_observer* observer;
+    while ((observer = coap_find_observer_by_addr(observers, MAX_OBSERVERS, &addr)) != nullptr)
+    {
+        dropObserver(observer);
+    }
+}
+
+void coapServer::handleAck(const struct coap_packet& request)
+{
+    uint16_t id = coap_header_get_id(&request);
+
+    /* The client is still there: the next confirmable is due after CON_EVERY notifications or a day */
+    for (auto& state : observer_state)
+    {
+        if (state.awaiting && (state.con_id == id))
+        {
+            state.awaiting = false;
+            state.last_con = k_uptime_get();
+            break;
+        }
+    }
+    scheduleConCheck();
+}
+
+void coapServer::resetObserver(struct coap_observer* observer)
+{
+    observer_state[observer - observers]          = {};
+    observer_state[observer - observers].last_con = k_uptime_get();
+}
+
+void coapServer::dropObserver(struct coap_observer* observer)
+{
+    for (auto& resource : resources)
+    {
+        if (resource.path != nullptr)
+        {
+            coap_remove_observer(&resource, observer);
+        }
+    }
+    memset(observer, 0, sizeof(*observer));
+    observer_state[observer - observers] = {};
+}
+
+void coapServer::scheduleConCheck()
+{
+    int64_t next = INT64_MAX;
+    for (const auto& state : observer_state)
+    {
+        next = state.awaiting ? MIN(next, state.deadline) : next;
+    }
+
+    if (next == INT64_MAX)
+    {
+        k_work_cancel_delayable(&con_work);
+        return;
+    }
+    k_work_reschedule(&con_work, K_MSEC(MAX(next - k_uptime_get(), 0)));
+}
+
+void coapServer::conTimeout(struct k_work* work)
+{
+    ARG_UNUSED(work);
+    coapServer& self = getInstance();
+    int64_t     now  = k_uptime_get();
+
+    k_mutex_lock(&self.lock, K_FOREVER);
+
+    for (size_t i = 0; i < MAX_OBSERVERS; i++)
+    {
+        observerState&        state    = self.observer_state[i];
+        struct coap_observer* observer = &self.observers[i];
+        if (!state.awaiting || (now < state.deadline))
+        {
+            continue;
+        }
+
+        /* Unanswered after every retransmission: the client is gone, stop notifying it */
+        if (state.retransmits >= MAX_RETRANSMIT)
+        {
+            MYLOG("CoAP observer dropped: no ACK to %u retransmissions", state.retransmits);
+            self.dropObserver(observer);
+            continue;
+        }
+
+        /* Same message id, current value; the timeout doubles each time */
+        state.retransmits++;
+        state.deadline = now + (ACK_TIMEOUT_MS << state.retransmits);
+        self.sendValue(state.resource, &observer->addr, addrLen(&observer->addr), COAP_TYPE_CON, state.con_id,
+                       observer->token, observer->tkl, true);
+    }
+
+    self.scheduleConCheck();
+    k_mutex_unlock(&self.lock);
+}
+
+int coapServer::sendValue(struct coap_resource* resource, const struct sockaddr* addr, socklen_t addr_len,
+                          uint8_t type, uint16_t id, const uint8_t* token, uint8_t tkl, bool observe)
+{
+    sensorSlot*        slot = static_cast<sensorSlot*>(resource->user_data);
+    uint8_t            data[MAX_MSG_LEN];
+    struct coap_packet response;
+    char               text[16];
+
+    int ret = coap_packet_init(&response, data, sizeof(data), COAP_VERSION_1, type, tkl, token,
+                               COAP_RESPONSE_CODE_CONTENT, id);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    if (observe)
+    {
+        coap_append_option_int(&response, COAP_OPTION_OBSERVE, resource->age);
+    }
+    coap_append_option_int(&response, COAP_OPTION_CONTENT_FORMAT, COAP_CONTENT_FORMAT_TEXT_PLAIN);
+
+    /* Latest recorded reading, or a live one before the first sample */
+    float value = (slot->count > 0) ? slot->history[(slot->head + HISTORY_LEN - 1) % HISTORY_LEN].value
+                                    : slot->source->get_value();
+    int len = snprintf(text, sizeof(text), "%.2f", (double)value);
+
+    coap_packet_append_payload_marker(&response);
+    coap_packet_append_payload(&response, (const uint8_t*)text, len);
+
+    return reply(response, addr, addr_len);
+}
+
+int coapServer::reply(struct coap_packet& response, const struct sockaddr* addr, socklen_t addr_len)
+{
+    ssize_t sent = sendto(sock, response.data, response.offset, 0, addr, addr_len);
+    return (sent < 0) ? -errno : 0;
+}
+
+socklen_t coapServer::addrLen(const struct sockaddr* addr)
+{
+    return (addr->sa_family == AF_INET6) ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+}
+
+int coapServer::valueGet(struct coap_resource* resource, struct coap_packet* request, struct sockaddr* addr,
+                         socklen_t addr_len)
+{
+    coapServer& self = getInstance();
+    uint8_t     token[COAP_TOKEN_MAX_LEN];
+    uint8_t     tkl      = coap_header_get_token(request, token);
+    int         observe  = coap_get_option_int(request, COAP_OPTION_OBSERVE);
+    bool        observed = false;
+
+    struct coap_observer* observer = coap_find_observer(self.observers, MAX_OBSERVERS, addr, token, tkl);
+
+    if (observe == 0)
+    {
+        /* Register, or refresh an existing registration */
+        if (observer == nullptr)
+        {
+            observer = coap_observer_next_unused(self.observers, MAX_OBSERVERS);
+            if (observer != nullptr)
+            {
+                coap_observer_init(observer, request, addr);
+                coap_register_observer(resource, observer);
+                self.resetObserver(observer);
+            }
+            else
+            {
+                MYLOG("CoAP observer table full");
+            }
+        }
+        observed = (observer != nullptr);
+    }
+    else if ((observe == 1) && (observer != nullptr))
+    {
+        coap_remove_observer(resource, observer);
+        memset(observer, 0, sizeof(*observer));
+        self.observer_state[observer - self.observers] = {};
+        self.scheduleConCheck();
+    }
+
+    bool con = (coap_header_get_type(request) == COAP_TYPE_CON);
+    return self.sendValue(resource, addr, addr_len, con ? COAP_TYPE_ACK : COAP_TYPE_NON_CON,
+                          con ? coap_header_get_id(request) : coap_next_id(), token, tkl, observed);
+}
+
+void coapServer::valueNotify(struct coap_resource* resource, struct coap_observer* observer)
+{
+    coapServer&    self  = getInstance();
+    observerState& state = self.observer_state[observer - self.observers];
+    int64_t        now   = k_uptime_get();
+
+    /* Mostly non-confirmable, a client that no longer wants them answers with RST. A periodic confirmable
+     * notification finds clients that went away without one (RFC 7641, 4.5). */
+    state.notified++;
+    bool con = !state.awaiting &&
+               (((state.notified % CON_EVERY) == 0) || ((now - state.last_con) >= CON_MAX_INTERVAL_MS));
+    if (!con)
+    {
+        self.sendValue(resource, &observer->addr, addrLen(&observer->addr), COAP_TYPE_NON_CON, coap_next_id(),
+                       observer->token, observer->tkl, true);
+        return;
+    }
+
+    state.resource    = resource;
+    state.con_id      = coap_next_id();
+    state.retransmits = 0;
+    state.deadline    = now + ACK_TIMEOUT_MS;
+    state.awaiting    = true;
+    self.sendValue(resource, &observer->addr, addrLen(&observer->addr), COAP_TYPE_CON, state.con_id,
+                   observer->token, observer->tkl, true);
+    self.scheduleConCheck();
+}
+
+int coapServer::historyGet(struct coap_resource* resource, struct coap_packet* request, struct sockaddr* addr,
+                           socklen_t addr_len)
+{
+    coapServer& self = getInstance();
+    sensorSlot* slot = static_cast<sensorSlot*>(resource->user_data);
+
+    /* Render oldest first, then slice the text into the requested block */
+    size_t total = 0;
+    for (size_t k = 0; k < slot->count; k++)
+    {
+        const sample& s = slot->history[(slot->head + HISTORY_LEN - slot->count + k) % HISTORY_LEN];
+        int n = snprintf(self.history_text + total, sizeof(self.history_text) - total, "%lld,%.2f\n",
+                         (long long)s.epoch_us, (double)s.value);
+        if ((n < 0) || ((size_t)n >= sizeof(self.history_text) - total))
+        {
+            break;
+        }
+        total += n;
+    }
+
+    uint32_t             num = 0;
+    enum coap_block_size szx = MAX_BLOCK_SIZE;
+    int                  opt = coap_get_option_int(request, COAP_OPTION_BLOCK2);
+    if (opt >= 0)
+    {
+        /* Honour a smaller block size; for a larger one rescale the block number to ours */
+        enum coap_block_size wanted = static_cast<enum coap_block_size>(opt & 0x7);
+        num                         = (uint32_t)opt >> 4;
+        if (wanted <= MAX_BLOCK_SIZE)
+        {
+            szx = wanted;
+        }
+        else
+        {
+            num *= coap_block_size_to_bytes(wanted) / coap_block_size_to_bytes(MAX_BLOCK_SIZE);
+        }
+    }
+
+    size_t block  = coap_block_size_to_bytes(szx);
+    size_t offset = num * block;
+    bool   con    = (coap_header_get_type(request) == COAP_TYPE_CON);
+
+    uint8_t            token[COAP_TOKEN_MAX_LEN];
+    uint8_t            tkl = coap_header_get_token(request, token);
+    uint8_t            data[MAX_MSG_LEN];
+    struct coap_packet response;
+
+    uint8_t code = (offset > total) ? COAP_RESPONSE_CODE_BAD_OPTION : COAP_RESPONSE_CODE_CONTENT;
+    int     ret  = coap_packet_init(&response, data, sizeof(data), COAP_VERSION_1,
+                                    con ? COAP_TYPE_ACK : COAP_TYPE_NON_CON, tkl, token, code,
+                                    con ? coap_header_get_id(request) : coap_next_id());
+    if ((ret < 0) || (code != COAP_RESPONSE_CODE_CONTENT))
+    {
+        return (ret < 0) ? ret : self.reply(response, addr, addr_len);
+    }
+
+    size_t chunk = MIN(block, total - offset);
+    bool   more  = (offset + chunk) < total;
+
+    /* The ETag changes with every new reading so clients can tell the blocks apart */
+    coap_append_option_int(&response, COAP_OPTION_ETAG, slot->total);
+    coap_append_option_int(&response, COAP_OPTION_CONTENT_FORMAT, COAP_CONTENT_FORMAT_TEXT_PLAIN);
+    coap_append_option_int(&response, COAP_OPTION_BLOCK2, (num << 4) | (more ? 0x8 : 0) | szx);
+    coap_append_option_int(&response, COAP_OPTION_SIZE2, total);
+
+    if (chunk > 0)
+    {
+        coap_packet_append_payload_marker(&response);
+        coap_packet_append_payload(&response, (const uint8_t*)self.history_text + offset, chunk);
+    }
+
+    return self.reply(response, addr, addr_len);
+}
+
+int coapServer::wellKnownGet(struct coap_resource* resource, struct coap_packet* request, struct sockaddr* addr,
+                             socklen_t addr_len)
+{
+    ARG_UNUSED(resource);
+
+    coapServer& self = getInstance();
+    char        links[MAX_MSG_LEN - 32];
+    size_t      len = 0;
+
+    /* Link format (RFC 6690); the Zephyr helper would read our user_data as link attributes */
+    for (size_t i = 0; i < self.slot_count; i++)
+    {
+        const char* id = self.slots[i].source->get_id();
+        int n = snprintf(links + len, sizeof(links) - len, "%s</sensors/%s>;obs,</sensors/%s/history>",
+                         (len > 0) ? "," : "", id, id);
+        if ((n < 0) || ((size_t)n >= sizeof(links) - len))
+        {
+            break;
+        }
+        len += n;
+    }
+
+    uint8_t            token[COAP_TOKEN_MAX_LEN];
+    uint8_t            tkl = coap_header_get_token(request, token);
+    bool               con = (coap_header_get_type(request) == COAP_TYPE_CON);
+    uint8_t            data[MAX_MSG_LEN];
+    struct coap_packet response;
+
+    int ret = coap_packet_init(&response, data, sizeof(data), COAP_VERSION_1, con ? COAP_TYPE_ACK : COAP_TYPE_NON_CON,
+                               tkl, token, COAP_RESPONSE_CODE_CONTENT,
+                               con ? coap_header_get_id(request) : coap_next_id());
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    coap_append_option_int(&response, COAP_OPTION_CONTENT_FORMAT, COAP_CONTENT_FORMAT_APP_LINK_FORMAT);
+    coap_packet_append_payload_marker(&response);
+    coap_packet_append_payload(&response, (const uint8_t*)links, len);
+
+    return self.reply(response, addr, addr_len);
+}
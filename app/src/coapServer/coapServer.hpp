@@ -0,0 +1,192 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2024 Osama Salah-ud-din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "sensor.hpp"
+#include <zephyr/kernel.h>
+#include <zephyr/net/coap.h>
+#include <zephyr/net/socket.h>
+
+/**
+ * @class coapServer
+ * @brief CoAP resource server exposing the sensors of sensorManager for pull-based telemetry.
+ *
+ * Every registered sensor gets two resources:
+ * - sensors/<id>: latest reading, GET and Observe (RFC 7641)
+ * - sensors/<id>/history: recent readings as "epoch_us,value" lines, served block-wise (RFC 7959)
+ *
+ * Requests are served on the socketManager network thread through a watched
+ * descriptor. Notifications go out only to registered observers, so nothing is
+ * sent while no one is subscribed. Every CON_EVERY-th notification, and at least
+ * one per CON_MAX_INTERVAL_MS, is confirmable (RFC 7641, 4.5): an observer that
+ * does not acknowledge it after MAX_RETRANSMIT retransmissions is removed.
+ */
+class coapServer
+{
+  public:
+    /**
+     * @brief Get the singleton instance of the coapServer class.
+     * @return Reference to the singleton instance.
+     */
+    static coapServer& getInstance();
+
+    /* Delete copy constructor and assignment operator */
+    coapServer(const coapServer&)            = delete;
+    coapServer& operator=(const coapServer&) = delete;
+
+    /**
+     * @brief Build the resources from sensorManager and start serving.
+     * @note Call after all sensors have been added.
+     * @return true if the server socket is bound and watched.
+     */
+    bool init();
+
+    /**
+     * @brief Record a new reading and notify the observers of that sensor.
+     * @param source Sensor the reading belongs to.
+     * @param value The reading.
+     * @param epoch_us Epoch time of the read in microseconds, 0 before the first time sync.
+     */
+    void publish(const sensor* source, float value, int64_t epoch_us);
+
+  private:
+    /**
+     * @brief Sensors that can be exposed.
+     */
+    static constexpr size_t MAX_SENSORS = 4;
+
+    /**
+     * @brief Observers shared by all resources.
+     */
+    static constexpr size_t MAX_OBSERVERS = 4;
+
+    /**
+     * @brief Largest CoAP message sent or received.
+     */
+    static constexpr size_t MAX_MSG_LEN = 256;
+
+    /**
+     * @brief Options parsed per request.
+     */
+    static constexpr uint8_t MAX_OPTIONS = 16;
+
+    /**
+     * @brief Largest block the server sends, block-wise transfers use at most this size.
+     */
+    static constexpr enum coap_block_size MAX_BLOCK_SIZE = COAP_BLOCK_128;
+
+    /**
+     * @brief Readings kept per sensor for the history resource.
+     */
+    static constexpr size_t HISTORY_LEN = CONFIG_APP_COAP_HISTORY_LEN;
+
+    /**
+     * @brief Buffer the history text is rendered into before slicing it into blocks.
+     */
+    static constexpr size_t HISTORY_TEXT_LEN = HISTORY_LEN * 32;
+
+    /**
+     * @brief Notifications per observer of which one is sent confirmable.
+     */
+    static constexpr uint32_t CON_EVERY = 16;
+
+    /**
+     * @brief Longest time between confirmable notifications to one observer (24 h, RFC 7641 4.5).
+     */
+    static constexpr int64_t CON_MAX_INTERVAL_MS = 24LL * 60 * 60 * 1000;
+
+    /**
+     * @brief Initial retransmission timeout of a confirmable notification (RFC 7252 ACK_TIMEOUT).
+     */
+    static constexpr int64_t ACK_TIMEOUT_MS = 2000;
+
+    /**
+     * @brief Retransmissions of a confirmable notification before the observer is dropped (RFC 7252).
+     */
+    static constexpr uint8_t MAX_RETRANSMIT = 4;
+
+    struct sample
+    {
+        int64_t epoch_us;
+        float   value;
+    };
+
+    /**
+     * @brief Liveness of an observer, parallel to observers[].
+     */
+    struct observerState
+    {
+        struct coap_resource* resource;    /**< Resource of the confirmable notification in flight */
+        uint32_t              notified;    /**< Notifications sent since registration */
+        int64_t               last_con;    /**< Uptime of the last acknowledged or registration exchange */
+        int64_t               deadline;    /**< Uptime of the next retransmission */
+        uint16_t              con_id;      /**< Message id the ACK must carry */
+        uint8_t               retransmits; /**< Retransmissions of the confirmable in flight */
+        bool                  awaiting;    /**< A confirmable notification is unacknowledged */
+    };
+
+    /**
+     * @brief Per sensor state, the resources point at it through user_data.
+     */
+    struct sensorSlot
+    {
+        const sensor* source;
+        const char*   value_path[3];
+        const char*   history_path[4];
+        sample        history[HISTORY_LEN];
+        size_t        head;
+        size_t        count;
+        uint32_t      total; /**< Readings ever recorded, used as ETag of the history */
+    };
+
+    struct k_mutex          lock;
+    int                     sock = -1;
+    bool                    is_initialized = false;
+    sensorSlot              slots[MAX_SENSORS];
+    size_t                  slot_count = 0;
+    struct coap_resource    resources[1 + (2 * MAX_SENSORS) + 1];
+    struct coap_observer    observers[MAX_OBSERVERS];
+    observerState           observer_state[MAX_OBSERVERS];
+    struct k_work_delayable con_work; /**< Retransmission and timeout of confirmable notifications */
+    char                    history_text[HISTORY_TEXT_LEN];
+
+    coapServer();
+
+    void handleDatagram();
+    void handleReset(const struct coap_packet& request, const struct sockaddr& addr);
+    void handleAck(const struct coap_packet& request);
+    void resetObserver(struct coap_observer* observer);
+    void dropObserver(struct coap_observer* observer);
+    void scheduleConCheck();
+    int  sendValue(struct coap_resource* resource, const struct sockaddr* addr, socklen_t addr_len, uint8_t type,
+                   uint16_t id, const uint8_t* token, uint8_t tkl, bool observe);
+    int  reply(struct coap_packet& response, const struct sockaddr* addr, socklen_t addr_len);
+
+    static socklen_t addrLen(const struct sockaddr* addr);
+    static void      onReadable(int fd, void* ctx);
+    static int       valueGet(struct coap_resource* resource, struct coap_packet* request, struct sockaddr* addr,
+                              socklen_t addr_len);
+    static int       historyGet(struct coap_resource* resource, struct coap_packet* request, struct sockaddr* addr,
+                                socklen_t addr_len);
+    static int       wellKnownGet(struct coap_resource* resource, struct coap_packet* request, struct sockaddr* addr,
+                                  socklen_t addr_len);
+    static void      valueNotify(struct coap_resource* resource, struct coap_observer* observer);
+    static void      conTimeout(struct k_work* work);
+};
@@ -0,0 +1,339 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2025 Osama Salah-ud-Din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "dnsCache.hpp"
+#include "myLogger.hpp"
+
+#include <zephyr/net/net_ip.h>
+#include <cerrno>
+#include <cstring>
+
+dnsCache& dnsCache::getInstance()
+{
+    static dnsCache instance;
+    return instance;
+}
+
+dnsCache::dnsCache()
+{
+    k_mutex_init(&lock);
+    memset(entries, 0, sizeof(entries));
+}
+
+int dnsCache::lookup(const std::string& host, uint16_t port, struct sockaddr& addr, socklen_t& addrlen)
+{
+    if (host.empty())
+    {
+        return -EINVAL;
+    }
+
+    /* Literal addresses never touch the cache */
+    if (net_ipaddr_parse(host.c_str(), host.length(), &addr))
+    {
+        addrlen = (addr.sa_family == AF_INET6) ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+        setPort(addr, port);
+        return 0;
+    }
+
+    k_mutex_lock(&lock, K_FOREVER);
+
+    entry* e = acquire(host);
+    if (e == nullptr)
+    {
+        k_mutex_unlock(&lock);
+        return -ENOMEM;
+    }
+
+    /* Without a race to go by, single-address users stay on IPv4 when they can */
+    const familyRecord& first  = (e->preferred == AF_INET6) ? e->ipv6 : e->ipv4;
+    const familyRecord& second = (e->preferred == AF_INET6) ? e->ipv4 : e->ipv6;
+
+    bool found = copyCurrent(first, port, addr, addrlen) || copyCurrent(second, port, addr, addrlen);
+
+    k_mutex_unlock(&lock);
+    return found ? 0 : -EAGAIN;
+}
+
+int dnsCache::candidates(const std::string& host, uint16_t port, struct sockaddr* addrs, socklen_t* addrlens)
+{
+    if (host.empty())
+    {
+        return -EINVAL;
+    }
+
+    if (net_ipaddr_parse(host.c_str(), host.length(), &addrs[0]))
+    {
+        addrlens[0] = (addrs[0].sa_family == AF_INET6) ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+        setPort(addrs[0], port);
+        return 1;
+    }
+
+    k_mutex_lock(&lock, K_FOREVER);
+
+    entry* e = acquire(host);
+    if (e == nullptr)
+    {
+        k_mutex_unlock(&lock);
+        return -ENOMEM;
+    }
+
+    /* RFC 8305: IPv6 first unless this host has already shown IPv4 to win */
+    const familyRecord& first  = (e->preferred == AF_INET) ? e->ipv4 : e->ipv6;
+    const familyRecord& second = (e->preferred == AF_INET) ? e->ipv6 : e->ipv4;
+
+    int count = 0;
+    if (copyCurrent(first, port, addrs[count], addrlens[count]))
+    {
+        count++;
+    }
+    if (copyCurrent(second, port, addrs[count], addrlens[count]))
+    {
+        count++;
+    }
+
+    k_mutex_unlock(&lock);
+    return (count > 0) ? count : -EAGAIN;
+}
+
+void dnsCache::prefetch(const std::string& host)
+{
+    struct sockaddr addr;
+    socklen_t       addrlen;
+
+    lookup(host, 0, addr, addrlen);
+}
+
+void dnsCache::setPreferredFamily(const std::string& host, sa_family_t family)
+{
+    k_mutex_lock(&lock, K_FOREVER);
+
+    entry* e = find(host);
+    if ((e != nullptr) && (e->preferred != family))
+    {
+        MYLOG("%s now prefers %s", e->host, (family == AF_INET6) ? "IPv6" : "IPv4");
+        e->preferred = family;
+    }
+
+    k_mutex_unlock(&lock);
+}
+
+void dnsCache::reportFailure(const std::string& host, const struct sockaddr& addr)
+{
+    k_mutex_lock(&lock, K_FOREVER);
+
+    entry* e = find(host);
+    if (e != nullptr)
+    {
+        familyRecord& f = (addr.sa_family == AF_INET6) ? e->ipv6 : e->ipv4;
+        if ((f.count > 1) && sameAddress(f.addrs[f.current], addr))
+        {
+            f.current = (f.current + 1) % f.count;
+            MYLOG("DNS failover for %s to address %u", e->host, f.current);
+        }
+    }
+
+    k_mutex_unlock(&lock);
+}
+
+dnsCache::entry* dnsCache::find(const std::string& host)
+{
+    for (auto& e : entries)
+    {
+        if (e.in_use && (strncmp(e.host, host.c_str(), HOST_MAX_LEN) == 0))
+        {
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+dnsCache::entry* dnsCache::acquire(const std::string& host)
+{
+    entry* e = find(host);
+    if (e == nullptr)
+    {
+        e = allocate(host);
+    }
+
+    if (e != nullptr)
+    {
+        e->last_used = k_uptime_get();
+        refresh(e->ipv4);
+        if (IS_ENABLED(CONFIG_NET_IPV6))
+        {
+            refresh(e->ipv6);
+        }
+    }
+    return e;
+}
+
+dnsCache::entry* dnsCache::allocate(const std::string& host)
+{
+    if (host.length() >= HOST_MAX_LEN)
+    {
+        MYLOG("Hostname too long for DNS cache: %s", host.c_str());
+        return nullptr;
+    }
+
+    /* Prefer a free slot, otherwise evict the least recently used idle entry */
+    entry* victim = nullptr;
+    for (auto& e : entries)
+    {
+        if (!e.in_use)
+        {
+            victim = &e;
+            break;
+        }
+        bool idle = !e.ipv4.pending && !e.ipv6.pending;
+        if (idle && ((victim == nullptr) || (e.last_used < victim->last_used)))
+        {
+            victim = &e;
+        }
+    }
+
+    if (victim != nullptr)
+    {
+        memset(victim, 0, sizeof(*victim));
+        strncpy(victim->host, host.c_str(), HOST_MAX_LEN - 1);
+        victim->ipv4.owner  = victim;
+        victim->ipv4.family = AF_INET;
+        victim->ipv6.owner  = victim;
+        victim->ipv6.family = AF_INET6;
+        victim->preferred   = AF_UNSPEC;
+        victim->in_use      = true;
+    }
+    return victim;
+}
+
+void dnsCache::refresh(familyRecord& f)
+{
+    int64_t now = k_uptime_get();
+
+    if (f.pending)
+    {
+        return;
+    }
+
+    if ((f.resolved_at != 0) && (now - f.resolved_at < (int64_t)CONFIG_APP_DNS_CACHE_TTL * MSEC_PER_SEC))
+    {
+        return;
+    }
+
+    if ((f.failed_at != 0) && (now - f.failed_at < NEGATIVE_TTL_MS))
+    {
+        return;
+    }
+
+    enum dns_query_type type = (f.family == AF_INET6) ? DNS_QUERY_TYPE_AAAA : DNS_QUERY_TYPE_A;
+
+    f.staged_count = 0;
+    int ret = dns_get_addr_info(f.owner->host, type, &f.query_id, resolveCallback, &f, QUERY_TIMEOUT_MS);
+    if (ret < 0)
+    {
+        MYLOG("DNS query for %s failed to start: %d", f.owner->host, ret);
+        f.failed_at = now;
+        return;
+    }
+    f.pending = true;
+}
+
+bool dnsCache::copyCurrent(const familyRecord& f, uint16_t port, struct sockaddr& addr, socklen_t& addrlen)
+{
+    if (f.count == 0)
+    {
+        return false;
+    }
+
+    addr    = f.addrs[f.current];
+    addrlen = f.addrlens[f.current];
+    setPort(addr, port);
+    return true;
+}
+
+bool dnsCache::sameAddress(const struct sockaddr& a, const struct sockaddr& b)
+{
+    if (a.sa_family != b.sa_family)
+    {
+        return false;
+    }
+
+    if (a.sa_family == AF_INET6)
+    {
+        return net_ipv6_addr_cmp(&net_sin6(&a)->sin6_addr, &net_sin6(&b)->sin6_addr);
+    }
+    return net_ipv4_addr_cmp(&net_sin(&a)->sin_addr, &net_sin(&b)->sin_addr);
+}
+
+void dnsCache::setPort(struct sockaddr& addr, uint16_t port)
+{
+    if (addr.sa_family == AF_INET6)
+    {
+        net_sin6(&addr)->sin6_port = htons(port);
+    }
+    else
+    {
+        net_sin(&addr)->sin_port = htons(port);
+    }
+}
+
+void dnsCache::resolveCallback(enum dns_resolve_status status, struct dns_addrinfo* info, void* user_data)
+{
+    dnsCache&     self = getInstance();
+    familyRecord* f    = static_cast<familyRecord*>(user_data);
+
+    k_mutex_lock(&self.lock, K_FOREVER);
+
+    if (status == DNS_EAI_INPROGRESS)
+    {
+        if ((info != nullptr) && (info->ai_family == f->family) && (f->staged_count < MAX_ADDRS))
+        {
+            memcpy(&f->staged[f->staged_count], &info->ai_addr, info->ai_addrlen);
+            f->staged_lens[f->staged_count] = info->ai_addrlen;
+            f->staged_count++;
+        }
+    }
+    else
+    {
+        /* ALLDONE, timeout or error all end the query */
+        if (f->staged_count > 0)
+        {
+            memcpy(f->addrs, f->staged, sizeof(f->addrs));
+            memcpy(f->addrlens, f->staged_lens, sizeof(f->addrlens));
+            f->count       = f->staged_count;
+            f->current     = 0;
+            f->resolved_at = k_uptime_get();
+            f->failed_at   = 0;
+        }
+        else if ((status == DNS_EAI_ALLDONE) || (status == DNS_EAI_NODATA))
+        {
+            /* The host has no records of this family (e.g. no AAAA), cache that like an answer */
+            f->count       = 0;
+            f->resolved_at = k_uptime_get();
+            f->failed_at   = 0;
+        }
+        else
+        {
+            MYLOG("DNS resolution of %s failed: %d", f->owner->host, status);
+            f->failed_at = k_uptime_get();
+        }
+        f->pending = false;
+    }
+
+    k_mutex_unlock(&self.lock);
+}
@@ -0,0 +1,166 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2025 Osama Salah-ud-Din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/net/dns_resolve.h>
+#include <string>
+
+/**
+ * @class dnsCache
+ * @brief Shared, non-blocking DNS cache for hostnames used by the sockets and SNTP.
+ *
+ * Lookups are answered from the cache only. Missing or expired entries are
+ * resolved asynchronously through the Zephyr DNS resolver, so a lookup never
+ * waits on the network. Expired entries keep being served until the refresh
+ * completes, and every resolved address is kept so callers can fail over.
+ * A and AAAA records are resolved side by side for dual-stack connects.
+ */
+class dnsCache
+{
+  public:
+    /**
+     * @brief Get the singleton instance of the dnsCache class.
+     * @return Reference to the singleton instance.
+     */
+    static dnsCache& getInstance();
+
+    /**
+     * @brief Look up a host without blocking.
+     * @param host Hostname or literal IP address.
+     * @param port Port to store in the returned address.
+     * @param addr Filled with the current address of the host.
+     * @param addrlen Filled with the length of addr.
+     * @return 0 on success, -EAGAIN while a resolution is in flight, -EINVAL for an empty host.
+     */
+    int lookup(const std::string& host, uint16_t port, struct sockaddr& addr, socklen_t& addrlen);
+
+    /**
+     * @brief Start resolving a host in the background if it is not cached yet.
+     * @param host Hostname or literal IP address.
+     */
+    void prefetch(const std::string& host);
+
+    /**
+     * @brief Get the addresses to race for a dual-stack connect, without blocking.
+     * @note One address per resolved family, the preferred family first. IPv6 is
+     *       preferred until a connect race on this host has picked a winner.
+     * @param host Hostname or literal IP address.
+     * @param port Port to store in the returned addresses.
+     * @param addrs Filled with up to MAX_CANDIDATES addresses.
+     * @param addrlens Filled with the length of each address.
+     * @return Number of addresses, -EAGAIN while nothing is resolved yet, -EINVAL for an empty host.
+     */
+    int candidates(const std::string& host, uint16_t port, struct sockaddr* addrs, socklen_t* addrlens);
+
+    /**
+     * @brief Remember the address family that won a connect race to the host.
+     * @param host Hostname the race was run for.
+     * @param family Winning address family.
+     */
+    void setPreferredFamily(const std::string& host, sa_family_t family);
+
+    /**
+     * @brief Report that an address of the host did not answer.
+     * @note The next lookup returns the next resolved address of that family, if any.
+     */
+    void reportFailure(const std::string& host, const struct sockaddr& addr);
+
+    /**
+     * @brief Most addresses returned by candidates(), one per address family.
+     */
+    static constexpr size_t MAX_CANDIDATES = 2;
+
+  private:
+    /**
+     * @brief Number of hosts kept in the cache.
+     */
+    static constexpr size_t MAX_ENTRIES = 8;
+
+    /**
+     * @brief Addresses kept per host and address family.
+     */
+    static constexpr size_t MAX_ADDRS = 4;
+
+    /**
+     * @brief Longest hostname that can be cached.
+     */
+    static constexpr size_t HOST_MAX_LEN = 64;
+
+    /**
+     * @brief Time a failed resolution is remembered before retrying.
+     */
+    static constexpr int64_t NEGATIVE_TTL_MS = 5000;
+
+    /**
+     * @brief Timeout of one DNS query.
+     */
+    static constexpr int32_t QUERY_TIMEOUT_MS = 3000;
+
+    struct entry;
+
+    /**
+     * @brief Resolution state of one address family (A or AAAA records) of a host.
+     */
+    struct familyRecord
+    {
+        entry*          owner;
+        sa_family_t     family;
+        struct sockaddr addrs[MAX_ADDRS];
+        socklen_t       addrlens[MAX_ADDRS];
+        size_t          count;
+        size_t          current;
+        struct sockaddr staged[MAX_ADDRS];
+        socklen_t       staged_lens[MAX_ADDRS];
+        size_t          staged_count;
+        int64_t         resolved_at;
+        int64_t         failed_at;
+        uint16_t        query_id;
+        bool            pending;
+    };
+
+    struct entry
+    {
+        char         host[HOST_MAX_LEN];
+        familyRecord ipv6;
+        familyRecord ipv4;
+        sa_family_t  preferred;
+        int64_t      last_used;
+        bool         in_use;
+    };
+
+    struct k_mutex lock;
+    entry          entries[MAX_ENTRIES];
+
+    dnsCache();
+    dnsCache(const dnsCache&)            = delete;
+    dnsCache& operator=(const dnsCache&) = delete;
+
+    entry* find(const std::string& host);
+    entry* acquire(const std::string& host);
+    entry* allocate(const std::string& host);
+    void   refresh(familyRecord& f);
+
+    static bool copyCurrent(const familyRecord& f, uint16_t port, struct sockaddr& addr, socklen_t& addrlen);
+    static bool sameAddress(const struct sockaddr& a, const struct sockaddr& b);
+    static void setPort(struct sockaddr& addr, uint16_t port);
+    static void resolveCallback(enum dns_resolve_status status, struct dns_addrinfo* info, void* user_data);
+};
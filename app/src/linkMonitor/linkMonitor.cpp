@@ -0,0 +1,345 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2025 Osama Salah-ud-Din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "linkMonitor.hpp"
+#include "pingManager.hpp"
+#include "dnsCache.hpp"
+#include "myLogger.hpp"
+
+#include <zephyr/shell/shell.h>
+#include <cstdio>
+
+/* pingManager takes any free slot, so two full trains fit as long as no other pings are outstanding */
+static_assert(CONFIG_APP_LINK_PROBE_TRAIN * linkMonitor::TARGET_COUNT <= pingManager::MAX_PENDING,
+              "Probe trains of both targets must fit in the ping request table");
+
+static constexpr uint32_t MIN_INTERVAL_MS = CONFIG_APP_LINK_PROBE_MIN_INTERVAL * 1000U;
+static constexpr uint32_t MAX_INTERVAL_MS = CONFIG_APP_LINK_PROBE_MAX_INTERVAL * 1000U;
+
+linkMonitor& linkMonitor::getInstance()
+{
+    static linkMonitor instance;
+    return instance;
+}
+
+linkMonitor::linkMonitor()
+{
+    for (size_t i = 0; i < TARGET_COUNT; i++)
+    {
+        probeTarget& t      = targets[i];
+        t.which             = static_cast<target>(i);
+        t.running           = false;
+        t.next_at           = INT64_MAX;
+        t.outstanding       = 0;
+        t.answered          = 0;
+        t.train_size        = 0;
+        t.window_pos        = 0;
+        t.window_count      = 0;
+        t.last_rtt_us       = 0;
+        t.has_last_rtt      = false;
+        t.stats             = {};
+        t.stats.interval_ms = MIN_INTERVAL_MS;
+    }
+}
+
+void linkMonitor::setTarget(target which, const std::string& host)
+{
+    targets[which].host = host;
+}
+
+void linkMonitor::setListener(listener fn, void* ctx)
+{
+    notify     = fn;
+    notify_ctx = ctx;
+}
+
+void linkMonitor::start(struct net_if* _iface)
+{
+    int64_t now = k_uptime_get();
+
+    iface = _iface;
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    for (probeTarget& t : targets)
+    {
+        t.running           = !t.host.empty();
+        t.next_at           = now + START_DELAY_MS;
+        t.stats.interval_ms = MIN_INTERVAL_MS;
+    }
+    k_spin_unlock(&lock, key);
+}
+
+void linkMonitor::stop()
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    for (probeTarget& t : targets)
+    {
+        t.running         = false;
+        t.next_at         = INT64_MAX;
+        t.stats.reachable = false;
+    }
+    k_spin_unlock(&lock, key);
+}
+
+void linkMonitor::tick()
+{
+    int64_t now = k_uptime_get();
+
+    for (probeTarget& t : targets)
+    {
+        k_spinlock_key_t key = k_spin_lock(&lock);
+        bool             due = t.running && (t.outstanding == 0) && (now >= t.next_at);
+        k_spin_unlock(&lock, key);
+
+        if (due)
+        {
+            sendTrain(t, now);
+        }
+    }
+}
+
+int64_t linkMonitor::nextProbe()
+{
+    int64_t next = INT64_MAX;
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    for (const probeTarget& t : targets)
+    {
+        if (t.running)
+        {
+            next = MIN(next, t.next_at);
+        }
+    }
+    k_spin_unlock(&lock, key);
+
+    return next;
+}
+
+void linkMonitor::sendTrain(probeTarget& t, int64_t now)
+{
+    struct sockaddr addr;
+    socklen_t       addrlen;
+
+    if (dnsCache::getInstance().lookup(t.host, 0, addr, addrlen) < 0)
+    {
+        MYLOG("%s not resolved yet", t.host.c_str());
+
+        k_spinlock_key_t key = k_spin_lock(&lock);
+        t.next_at            = now + MIN_INTERVAL_MS;
+        k_spin_unlock(&lock, key);
+        return;
+    }
+
+    /* Replies may come back before the last ping of the train is sent */
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    t.outstanding        = CONFIG_APP_LINK_PROBE_TRAIN;
+    t.answered           = 0;
+    t.train_size         = CONFIG_APP_LINK_PROBE_TRAIN;
+    t.next_at            = INT64_MAX;
+    t.stats.sent += CONFIG_APP_LINK_PROBE_TRAIN;
+    k_spin_unlock(&lock, key);
+
+    for (size_t i = 0; i < CONFIG_APP_LINK_PROBE_TRAIN; i++)
+    {
+        if (!pingManager::getInstance().send_ping(addr, iface, onReply, &t))
+        {
+            /* Not sent: neither a reply nor a loss */
+            key = k_spin_lock(&lock);
+            t.stats.sent--;
+            t.train_size--;
+            finishProbe(t, key);
+        }
+    }
+}
+
+void linkMonitor::onReply(bool reachable, uint32_t rtt_us, void* ctx)
+{
+    getInstance().record(*static_cast<probeTarget*>(ctx), reachable, rtt_us);
+}
+
+void linkMonitor::record(probeTarget& t, bool answered, uint32_t rtt_us)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    linkStats&       s   = t.stats;
+
+    if (answered)
+    {
+        s.received++;
+        t.answered++;
+
+        uint32_t ms     = rtt_us / 1000U;
+        size_t   bucket = (ms > 0) ? (32 - __builtin_clz(ms)) : 0;
+        s.histogram[MIN(bucket, RTT_BUCKETS - 1)]++;
+
+        /* J += (|D| - J) / 16 */
+        if (t.has_last_rtt)
+        {
+            int32_t d   = (int32_t)(rtt_us - t.last_rtt_us);
+            int32_t j   = (int32_t)s.jitter_us;
+            s.jitter_us = (uint32_t)(j + ((((d < 0) ? -d : d) - j) / 16));
+        }
+        t.last_rtt_us  = rtt_us;
+        t.has_last_rtt = true;
+    }
+    else
+    {
+        s.lost++;
+    }
+
+    t.window[t.window_pos] = answered ? rtt_us : LOST;
+    t.window_pos           = (t.window_pos + 1) % WINDOW;
+    t.window_count         = MIN(t.window_count + 1, WINDOW);
+
+    uint32_t rtt_min = UINT32_MAX;
+    uint32_t rtt_max = 0;
+    uint64_t rtt_sum = 0;
+    uint32_t lost    = 0;
+
+    for (size_t i = 0; i < t.window_count; i++)
+    {
+        if (t.window[i] == LOST)
+        {
+            lost++;
+            continue;
+        }
+        rtt_min = MIN(rtt_min, t.window[i]);
+        rtt_max = MAX(rtt_max, t.window[i]);
+        rtt_sum += t.window[i];
+    }
+
+    uint32_t replies = t.window_count - lost;
+    s.rtt_min_us     = replies ? rtt_min : 0;
+    s.rtt_max_us     = rtt_max;
+    s.rtt_avg_us     = replies ? (uint32_t)(rtt_sum / replies) : 0;
+    s.loss_permille  = (lost * 1000U) / t.window_count;
+
+    finishProbe(t, key);
+}
+
+void linkMonitor::finishProbe(probeTarget& t, k_spinlock_key_t key)
+{
+    bool report    = false;
+    bool reachable = false;
+
+    t.outstanding--;
+    if (t.outstanding == 0)
+    {
+        reachable = endTrain(t);
+        report    = t.running;
+    }
+    k_spin_unlock(&lock, key);
+
+    if (report && notify)
+    {
+        notify(t.which, reachable, notify_ctx);
+    }
+}
+
+bool linkMonitor::endTrain(probeTarget& t)
+{
+    linkStats& s = t.stats;
+
+    /* A clean train backs off, loss or jitter above half the RTT probes at the fastest rate again */
+    bool stable = (t.train_size > 0) && (t.answered == t.train_size) &&
+                  (s.jitter_us <= MAX(s.rtt_avg_us / 2, 1000U));
+
+    s.interval_ms = stable ? MIN(s.interval_ms * 2, MAX_INTERVAL_MS) : MIN_INTERVAL_MS;
+    s.reachable   = (t.answered > 0);
+    t.next_at     = k_uptime_get() + s.interval_ms;
+
+    return s.reachable;
+}
+
+linkMonitor::linkStats linkMonitor::getStats(target which)
+{
+    k_spinlock_key_t key   = k_spin_lock(&lock);
+    linkStats        stats = targets[which].stats;
+    k_spin_unlock(&lock, key);
+
+    return stats;
+}
+
+const char* linkMonitor::targetName(target which)
+{
+    return (which == LAN) ? "LAN" : "WAN";
+}
+
+size_t linkMonitor::formatStats(char* buffer, size_t len)
+{
+    size_t used = 0;
+
+    for (size_t i = 0; i < TARGET_COUNT; i++)
+    {
+        linkStats s = getStats(static_cast<target>(i));
+        int       n = snprintf(buffer + used, len - used,
+                               "%s %s rtt=%u/%u/%u jitter=%u loss=%u sent=%u recv=%u interval=%u hist=",
+                               targetName(static_cast<target>(i)), targets[i].host.c_str(), s.rtt_min_us, s.rtt_avg_us,
+                               s.rtt_max_us, s.jitter_us, s.loss_permille, s.sent, s.received, s.interval_ms);
+        for (size_t b = 0; (n > 0) && ((size_t)n < len - used) && (b < RTT_BUCKETS); b++)
+        {
+            n += snprintf(buffer + used + n, len - used - n, (b == 0) ? "%u" : ",%u", s.histogram[b]);
+        }
+        if ((n < 0) || ((size_t)n + 1 >= len - used))
+        {
+            break;
+        }
+        buffer[used + n] = '\n';
+        used += n + 1;
+    }
+
+    if (used < len)
+    {
+        buffer[used] = '\0';
+    }
+    return used;
+}
+
+#if defined(CONFIG_SHELL)
+static int cmdLinkStats(const struct shell* sh, size_t argc, char** argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    for (size_t i = 0; i < linkMonitor::TARGET_COUNT; i++)
+    {
+        linkMonitor::target    which = static_cast<linkMonitor::target>(i);
+        linkMonitor::linkStats s     = linkMonitor::getInstance().getStats(which);
+
+        shell_print(sh, "%s: %s, probing every %u ms", linkMonitor::targetName(which),
+                    s.reachable ? "reachable" : "unreachable", s.interval_ms);
+        shell_print(sh, "  rtt min/avg/max %u/%u/%u us, jitter %u us, loss %u.%u%%", s.rtt_min_us, s.rtt_avg_us,
+                    s.rtt_max_us, s.jitter_us, s.loss_permille / 10, s.loss_permille % 10);
+        shell_print(sh, "  %u sent, %u received, %u lost", s.sent, s.received, s.lost);
+        for (size_t b = 0; b < linkMonitor::RTT_BUCKETS; b++)
+        {
+            if (s.histogram[b] > 0)
+            {
+                bool last = (b == linkMonitor::RTT_BUCKETS - 1);
+                shell_print(sh, "    %s%5u ms: %u", last ? ">=" : "< ", 1U << (last ? b - 1 : b), s.histogram[b]);
+            }
+        }
+    }
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_link,
+                               SHELL_CMD(stats, NULL, "RTT, jitter and loss of the LAN and WAN targets", cmdLinkStats),
+                               SHELL_SUBCMD_SET_END);
+SHELL_CMD_REGISTER(link, &sub_link, "Link quality monitor", NULL);
+#endif
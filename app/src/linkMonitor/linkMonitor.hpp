@@ -0,0 +1,189 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2025 Osama Salah-ud-Din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/net_if.h>
+#include <string>
+
+/**
+ * @class linkMonitor
+ * @brief Link quality of the LAN and WAN targets from periodic ping trains.
+ *
+ * Every probe interval a train of CONFIG_APP_LINK_PROBE_TRAIN pings goes to each
+ * target. Replies and timeouts feed a rolling window (RTT min/avg/max and loss),
+ * a smoothed jitter estimate and an RTT histogram. A target is reachable while
+ * at least one ping of its last train was answered, so one dropped ping does not
+ * take the link down. Trains without loss or jitter stretch the interval up to
+ * CONFIG_APP_LINK_PROBE_MAX_INTERVAL; a lossy or jittery train resets it to
+ * CONFIG_APP_LINK_PROBE_MIN_INTERVAL.
+ */
+class linkMonitor
+{
+  public:
+    /**
+     * @brief Probed hosts.
+     */
+    enum target : uint8_t
+    {
+        LAN = 0,
+        WAN,
+        TARGET_COUNT,
+    };
+
+    /**
+     * @brief Number of RTT histogram buckets.
+     * @note Bucket 0 counts RTTs below 1 ms, bucket n RTTs in [2^(n-1), 2^n) ms, the last is open.
+     */
+    static constexpr size_t RTT_BUCKETS = 12;
+
+    /**
+     * @brief Number of recent probes the rolling statistics cover.
+     */
+    static constexpr size_t WINDOW = 32;
+
+    /**
+     * @brief Link quality of one target.
+     */
+    struct linkStats
+    {
+        uint32_t sent;                  /**< Probes sent */
+        uint32_t received;              /**< Probes answered */
+        uint32_t lost;                  /**< Probes timed out */
+        uint32_t rtt_min_us;            /**< Over the window */
+        uint32_t rtt_avg_us;            /**< Over the window */
+        uint32_t rtt_max_us;            /**< Over the window */
+        uint32_t jitter_us;             /**< Smoothed RTT variation (RFC 3550 estimator) */
+        uint32_t loss_permille;         /**< Over the window */
+        uint32_t interval_ms;           /**< Current probe interval */
+        bool     reachable;             /**< Last train got at least one reply */
+        uint32_t histogram[RTT_BUCKETS];
+    };
+
+    /**
+     * @brief Called when a train completes.
+     * @note Runs in the network RX thread or in tick(); it must not block.
+     */
+    using listener = void (*)(target which, bool reachable, void* ctx);
+
+    /**
+     * @brief Get the singleton instance of the linkMonitor class.
+     * @return Reference to the singleton instance.
+     */
+    static linkMonitor& getInstance();
+
+    /**
+     * @brief Set the host probed for @p which.
+     * @param host Hostname or literal IP address, resolved through the DNS cache.
+     */
+    void setTarget(target which, const std::string& host);
+
+    /**
+     * @brief Set the function told about each completed train.
+     */
+    void setListener(listener fn, void* ctx);
+
+    /**
+     * @brief Start probing, the first trains go out after START_DELAY_MS.
+     * @param iface Interface to send the probes on.
+     */
+    void start(struct net_if* iface);
+
+    /**
+     * @brief Stop probing and mark the targets unreachable.
+     * @note The statistics are kept.
+     */
+    void stop();
+
+    /**
+     * @brief Send the trains that are due.
+     */
+    void tick();
+
+    /**
+     * @brief Uptime at which the next train is due.
+     * @return Uptime in ms, or INT64_MAX when stopped.
+     */
+    int64_t nextProbe();
+
+    /**
+     * @brief Get the link quality of a target.
+     */
+    linkStats getStats(target which);
+
+    /**
+     * @brief Format the link quality of both targets, one line each.
+     * @return Number of characters written, without the terminating NUL.
+     */
+    size_t formatStats(char* buffer, size_t len);
+
+    /**
+     * @brief Name of a target, for logs.
+     */
+    static const char* targetName(target which);
+
+  private:
+    /**
+     * @brief Window slot of a probe that timed out.
+     */
+    static constexpr uint32_t LOST = UINT32_MAX;
+
+    /**
+     * @brief Delay between start() and the first trains, lets the DNS prefetch finish.
+     */
+    static constexpr uint32_t START_DELAY_MS = 2000;
+
+    struct probeTarget
+    {
+        target      which;
+        std::string host;
+        bool        running;
+        int64_t     next_at;
+
+        /* Train in flight */
+        uint8_t outstanding;
+        uint8_t answered;
+        uint8_t train_size;
+
+        /* Rolling window of RTTs, LOST for a timeout */
+        uint32_t window[WINDOW];
+        size_t   window_pos;
+        size_t   window_count;
+
+        uint32_t  last_rtt_us;
+        bool      has_last_rtt;
+        linkStats stats;
+    };
+
+    linkMonitor();
+
+    static void onReply(bool reachable, uint32_t rtt_us, void* ctx);
+
+    void record(probeTarget& t, bool answered, uint32_t rtt_us);
+    void finishProbe(probeTarget& t, k_spinlock_key_t key);
+    bool endTrain(probeTarget& t);
+    void sendTrain(probeTarget& t, int64_t now);
+
+    struct k_spinlock lock;
+    probeTarget       targets[TARGET_COUNT];
+    struct net_if*    iface      = nullptr;
+    listener          notify     = nullptr;
+    void*             notify_ctx = nullptr;
+};
@@ -27,6 +27,7 @@ LOG_MODULE_REGISTER(main, CONFIG_APP_LOG_LEVEL);
 
 #include "networkManager.hpp"
 #include "networkTimeManager.hpp"
+#include "linkMonitor.hpp"
 #include "socketManager.hpp"
 #include "sockets.hpp"
 
@@ -35,31 +36,58 @@ LOG_MODULE_REGISTER(main, CONFIG_APP_LOG_LEVEL);
 #include "lightSensor.hpp"
 #include "temperatureSensor.hpp"
 
-#define STACK_SIZE (4096)
-#define TASK_PRIORITY (-1)
+#if defined(CONFIG_APP_COAP_SERVER)
+#include "coapServer.hpp"
+#endif
 
-K_THREAD_STACK_DEFINE(ntp_stack, STACK_SIZE);
+/* Sensor sampling period while the network is up */
+#define SENSOR_PERIOD_MS (10000)
 
-static struct k_thread ntp_thread;
+/* CPU idle report period */
+#define IDLE_REPORT_MS (60000)
+
+/* Longest wait for the network state channel, held only while a message is copied */
+#define NETWORK_STATE_READ_MS (100)
+
+#if defined(CONFIG_APP_MQTT)
+/* All sensors share one broker connection and publish to their own topic */
+#define TELEMETRY_PROTOCOL (socketManager::protocol::MQTT)
+#define TELEMETRY_PORT(port) (CONFIG_APP_MQTT_BROKER_PORT)
+#else
+#define TELEMETRY_PROTOCOL (socketManager::protocol::UDP)
+#define TELEMETRY_PORT(port) (port)
+#endif
 
 K_MUTEX_DEFINE(mutex);
 K_CONDVAR_DEFINE(condvar);
 
-static void ntp_sync_thread(void*, void*, void*)
+#if defined(CONFIG_SCHED_THREAD_USAGE_ALL)
+/**
+ * @brief Log the share of CPU time spent in the idle thread since the last call.
+ */
+static void report_idle(void)
 {
-    networkManager&     network = networkManager::getInstance();
-    networkTimeManager& ntp     = networkTimeManager::getInstance();
+    static uint64_t last_idle  = 0;
+    static uint64_t last_total = 0;
 
-    while (true)
+    k_thread_runtime_stats_t stats;
+    if (k_thread_runtime_stats_all_get(&stats) != 0)
     {
-        if (network.isConnectedWAN())
-        {
-            ntp.tick();
-            MYLOG("⏰ System Time Synced");
-        }
-        k_sleep(K_MINUTES(1));
+        return;
+    }
+
+    /* execution_cycles counts idle and non-idle time */
+    uint64_t idle  = stats.idle_cycles - last_idle;
+    uint64_t total = stats.execution_cycles - last_total;
+    last_idle      = stats.idle_cycles;
+    last_total     = stats.execution_cycles;
+
+    if (total > 0)
+    {
+        MYLOG("💤 CPU idle: %u%%", (unsigned int)((idle * 100U) / total));
     }
 }
+#endif
 
 int main(void)
 {
@@ -75,78 +103,117 @@ int main(void)
     sockets socketAirQualitySensor;
     sockets socketLightSensor;
     sockets socketTempSensor;
+#if CONFIG_APP_SOCKET_STATS_INTERVAL > 0
+    sockets     socketStats;
+    static char statsReport[1024];
+    int64_t     statsDeadline = k_uptime_get() + (CONFIG_APP_SOCKET_STATS_INTERVAL * 1000LL);
+#endif
 
     networkManager& network = networkManager::getInstance();
     myLogger&       logger  = myLogger::getInstance();
 
+    /* Created before the network can publish: its network_state_chan listener does not create it */
+    networkTimeManager::getInstance();
+
     /* Initialize Network Manager */
     network.init();
     logger.init();
     sensorMgr.init();
 
+#if defined(CONFIG_APP_COAP_SERVER)
+    /* Pull mode: consumers GET or observe the sensors, nothing is pushed */
+    sensorMgr.add_sensor(&lightSensor);
+    sensorMgr.add_sensor(&airQualitySensor);
+    sensorMgr.add_sensor(&temperatureSensor);
+    coapServer::getInstance().init();
+#else
     sensorMgr.add_sensor(&lightSensor, &socketLightSensor);
     sensorMgr.add_sensor(&airQualitySensor, &socketAirQualitySensor);
     sensorMgr.add_sensor(&temperatureSensor, &socketTempSensor);
+#endif
 
-    socketLightSensor.open(networkManager::getInstance().getLocalServer(), portConfig::PORT_AIR_QUALITY_SENSOR,
-                           socketManager::protocol::UDP);
-
-    socketLightSensor.open(networkManager::getInstance().getLocalServer(), portConfig::PORT_LIGHT_SENSOR,
-                           socketManager::protocol::UDP);
-
-    socketLightSensor.open(networkManager::getInstance().getLocalServer(), portConfig::PORT_TEMP_SENSOR,
-                           socketManager::protocol::UDP);
-
-    bool isSocket =
-        socketTempSensor.open(network.getLocalServer(), portConfig::PORT_TEMP_SENSOR, socketManager::protocol::UDP);
+    bool isSocket = socketTempSensor.open(network.getLocalServer(), TELEMETRY_PORT(portConfig::PORT_TEMP_SENSOR),
+                                          TELEMETRY_PROTOCOL);
     if (!isSocket)
     {
         MYLOG(" Temperature Sensor Socket Initialization Failed: %d", isSocket);
     }
 
-    isSocket = socketAirQualitySensor.open(network.getLocalServer(), portConfig::PORT_AIR_QUALITY_SENSOR,
-                                           socketManager::protocol::UDP);
+    isSocket = socketAirQualitySensor.open(network.getLocalServer(),
+                                           TELEMETRY_PORT(portConfig::PORT_AIR_QUALITY_SENSOR), TELEMETRY_PROTOCOL);
     if (!isSocket)
     {
         MYLOG(" Air Quality Sensor Socket Initialization Failed: %d", isSocket);
     }
 
-    isSocket =
-        socketLightSensor.open(network.getLocalServer(), portConfig::PORT_LIGHT_SENSOR, socketManager::protocol::UDP);
+    isSocket = socketLightSensor.open(network.getLocalServer(), TELEMETRY_PORT(portConfig::PORT_LIGHT_SENSOR),
+                                      TELEMETRY_PROTOCOL);
     if (!isSocket)
     {
         MYLOG(" Light Sensor Socket Initialization Failed: %d", isSocket);
     }
 
-    uint64_t start = k_uptime_get();
+    /* Sampling must not stall on the network: sensors send through async queues */
+    socketTempSensor.setAsync(socketManager::overflowPolicy::DROP_OLDEST);
+    socketAirQualitySensor.setAsync(socketManager::overflowPolicy::DROP_OLDEST);
+    socketLightSensor.setAsync(socketManager::overflowPolicy::DROP_OLDEST);
 
-    /* Create a Thread for SNTP Issue */
-    k_thread_create(&ntp_thread, ntp_stack, K_THREAD_STACK_SIZEOF(ntp_stack), ntp_sync_thread, NULL, NULL, NULL,
-                    TASK_PRIORITY, 0, K_NO_WAIT);
+#if CONFIG_APP_SOCKET_STATS_INTERVAL > 0
+    if (!socketStats.open(network.getLocalServer(), portConfig::STATS_CONSOLE, socketManager::protocol::UDP))
+    {
+        MYLOG(" Socket Statistics Initialization Failed");
+    }
+#endif
+
+    int64_t      sensorDeadline = k_uptime_get() + SENSOR_PERIOD_MS;
+    int64_t      idleDeadline   = k_uptime_get() + IDLE_REPORT_MS;
+    networkState netState       = {.wifi = wifiStateEnum::IDLE};
 
     while (true)
     {
+        /* Sleep until a net_mgmt event, a network timer or the next sensor/report deadline */
+        int64_t deadline = MIN(network.nextDeadline(), idleDeadline);
+        if (netState.isUp())
+        {
+            deadline = MIN(deadline, sensorDeadline);
+#if CONFIG_APP_SOCKET_STATS_INTERVAL > 0
+            deadline = MIN(deadline, statsDeadline);
+#endif
+        }
+        network.waitForEvent(deadline);
+
         network.tick();
 
-        if (network.isNetworkUp())
+        /* tick() publishes any change: read the cached message rather than query the manager */
+        zbus_chan_read(&network_state_chan, &netState, K_MSEC(NETWORK_STATE_READ_MS));
+
+        if (k_uptime_get() >= idleDeadline)
         {
-            if (k_uptime_get() - start > 10000)
+            idleDeadline = k_uptime_get() + IDLE_REPORT_MS;
+#if defined(CONFIG_SCHED_THREAD_USAGE_ALL)
+            report_idle();
+#endif
+        }
+
+        if (netState.isUp())
+        {
+            if (k_uptime_get() >= sensorDeadline)
             {
                 sensorMgr.tick();
-                start = k_uptime_get();
-                if (network.isConnectedLAN())
+                sensorDeadline = k_uptime_get() + SENSOR_PERIOD_MS;
+                if (netState.lan)
                 {
                     MYLOG(" 💻 Connected to LAN");
                     if (isSocket)
                     {
-                        MYLOG("Sent Data to local server. Return: %d", socketTempSensor.send("LAN", 4));
+                        MYLOG("Sent Data to local server. Return: %d", (int)socketTempSensor.send("LAN", 4));
                     }
                 }
                 else
                 {
                     MYLOG("Not connected to LAN");
                 }
-                if (network.isConnectedWAN())
+                if (netState.wan)
                 {
                     MYLOG("🌐 Connected to WAN");
                 }
@@ -155,6 +222,18 @@ int main(void)
                     MYLOG("Not connected to WAN");
                 }
             }
+#if CONFIG_APP_SOCKET_STATS_INTERVAL > 0
+            if (k_uptime_get() >= statsDeadline)
+            {
+                statsDeadline = k_uptime_get() + (CONFIG_APP_SOCKET_STATS_INTERVAL * 1000LL);
+                size_t len = socketManager::getInstance().formatStats(statsReport, sizeof(statsReport));
+                len += linkMonitor::getInstance().formatStats(statsReport + len, sizeof(statsReport) - len);
+                if (len > 0)
+                {
+                    socketStats.send(statsReport, len);
+                }
+            }
+#endif
         }
     }
     return 0;
@@ -22,11 +22,28 @@
 #include "socketManager.hpp"
 #include "sockets.hpp"
 
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+
 char __mylog_msg[LOG_MSG_LENGTH];
 
 static networkManager& dbgNetwork = networkManager::getInstance();;
 static sockets dbgSocket;
 
+/* Follows network_state_chan, so a log line costs no call into the network manager */
+static atomic_t dbgNetworkUp = ATOMIC_INIT(0);
+
+static void network_state_listener(const struct zbus_channel* chan)
+{
+    const networkState* state = static_cast<const networkState*>(zbus_chan_const_msg(chan));
+
+    /* Runs in the publisher's context: no logging here */
+    atomic_set(&dbgNetworkUp, state->isUp());
+}
+
+ZBUS_LISTENER_DEFINE(logger_network_lis, network_state_listener);
+ZBUS_CHAN_ADD_OBS(network_state_chan, logger_network_lis, 0);
+
 /**
  * @brief Get the singleton instance of the networkManager class.
  * @return Reference to the singleton instance.
@@ -51,12 +68,25 @@ void myLogger::init()
     {
         MYLOG("Network Logger Initialization Failed");
     }
+    else
+    {
+        /* Logging must never wait on Wi-Fi, keep the newest lines instead */
+        dbgSocket.setAsync(socketManager::overflowPolicy::DROP_OLDEST);
+    }
 }
 
 void myLogger::send(const char* log_msg, size_t len)
 {
-    if (dbgNetwork.isNetworkUp())
+    if (atomic_get(&dbgNetworkUp))
     {
-        dbgSocket.send(log_msg, len);
+        /* snprintf reports the untruncated length */
+        len = MIN(len, (size_t)(LOG_MSG_LENGTH - 1));
+
+        /* Terminate the line on the wire without copying the message */
+        struct iovec line[] = {
+            {const_cast<char*>(log_msg), len},
+            {const_cast<char*>("\n"), 1},
+        };
+        dbgSocket.send(line, ARRAY_SIZE(line));
     }
 }
\ No newline at end of file
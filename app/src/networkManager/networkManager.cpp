@@ -19,6 +19,10 @@
 
 #include "networkManager.hpp"
 #include "myLogger.hpp"
+#include "dnsCache.hpp"
+
+ZBUS_CHAN_DEFINE(network_state_chan, networkState, NULL, NULL, ZBUS_OBSERVERS_EMPTY,
+                 ZBUS_MSG_INIT(.wifi = wifiStateEnum::IDLE));
 
 networkManager& networkManager::getInstance()
 {
@@ -30,13 +34,17 @@ networkManager& networkManager::getInstance()
  * @brief Constructor for the networkManager class.
  */
 networkManager::networkManager()
-    : WIFI_START_DELAY(1500U), WIFI_CONNECT_TIMEOUT(120000U), CONFIG_MY_LOCAL(MY_LOCAL), CONFIG_MY_REMOTE(MY_REMOTE),
-      wifi(wifiManager::getInstance()), ping(pingManager::getInstance())
+    : WIFI_START_DELAY(1500U), CONFIG_MY_LOCAL(MY_LOCAL), CONFIG_MY_REMOTE(MY_REMOTE),
+      wifi(wifiManager::getInstance()), ping(pingManager::getInstance()), monitor(linkMonitor::getInstance()),
+      policy(reconnectPolicy::getInstance()),
+      attempt_started(0), attempt_open(false), reconnect_at(0)
 {
     k_mutex_init(&state_mutex);
+    k_event_init(&events);
+    next_deadline = 0;
+    published     = {.wifi = wifiStateEnum::IDLE};
     atomic_set(&connection_attempts, 0);
     atomic_set(&start_time, 0);
-    atomic_set(&tick_count, 0);
     atomic_set(&is_connect_requested, false);
     atomic_set(&is_new_connection, false);
     atomic_set(&is_lan_connected, false);
@@ -51,6 +59,9 @@ bool networkManager::init()
 {
     bool ret = false;
 
+    /* Wi-Fi events wake the main loop instead of it polling the driver */
+    wifi.setEventNotifier(&events, EVENT_WIFI);
+
     /* Initialize Wi-Fi */
     if (!wifi.init())
     {
@@ -68,8 +79,12 @@ bool networkManager::init()
         return ret;
     }
 
+    /* Reachability follows probe trains instead of single pings */
+    monitor.setTarget(linkMonitor::LAN, CONFIG_MY_LOCAL);
+    monitor.setTarget(linkMonitor::WAN, CONFIG_MY_REMOTE);
+    monitor.setListener(onLinkResult, this);
+
     atomic_set(&start_time, k_uptime_get());
-    atomic_set(&tick_count, 0);
 
     MYLOG("NetworkManager initialized");
     ret = true;
@@ -89,27 +104,35 @@ void networkManager::tick()
 
     wifiStateEnum current_state = static_cast<wifiStateEnum>(atomic_get(&wifi_state));
     wifiStateEnum new_state     = wifi.getWifiState();
+    bool          pending       = (current_state != new_state);
 
     if (current_state != new_state)
     {
-        handleNetworkStateChange(new_state);
+        handleNetworkStateChange(current_state, new_state);
     }
 
     switch (new_state)
     {
         case wifiStateEnum::IDLE:
-            if ((k_uptime_get() - atomic_get(&start_time) > WIFI_START_DELAY) && !atomic_get(&is_connect_requested))
+            if ((k_uptime_get() - atomic_get(&start_time) > WIFI_START_DELAY) && !atomic_get(&is_connect_requested) &&
+                shouldReconnect())
             {
                 MYLOG("Waiting for Wifi to connect");
-                wifi.connect();
+                startAttempt();
                 atomic_set(&is_connect_requested, true);
                 atomic_set(&is_new_connection, true);
-                atomic_inc(&connection_attempts);
+                pending = true;
+            }
+            else if (attempt_open && (k_uptime_get() - attempt_started > policy.connectTimeout()))
+            {
+                /* The request was never taken up: count it and ask again after the policy's delay */
+                atomic_set(&is_connect_requested, false);
+                expireAttempt();
             }
             break;
 
         case wifiStateEnum::CONNECTING:
-            if (k_uptime_get() - atomic_get(&start_time) > WIFI_CONNECT_TIMEOUT)
+            if (k_uptime_get() - attempt_started > policy.connectTimeout())
             {
                 MYLOG("❌ Failed to connect to Wifi");
                 wifi.disconnect();
@@ -125,41 +148,105 @@ void networkManager::tick()
             {
                 atomic_set(&start_time, k_uptime_get());
                 atomic_set(&is_new_connection, false);
-            }
 
-            if ((k_uptime_get() - atomic_get(&start_time) > 10000) && !atomic_get(&is_new_connection))
-            {
-                ping.send_ping(CONFIG_MY_REMOTE.c_str(), wifi.get_wifi_iface(), setIsConnectedWAN);
-                ping.send_ping(CONFIG_MY_LOCAL.c_str(), wifi.get_wifi_iface(), setIsConnectedLAN);
-                atomic_set(&start_time, k_uptime_get());
-                atomic_inc(&tick_count);
+                /* Warm the DNS cache so the first probes do not miss */
+                dnsCache::getInstance().prefetch(CONFIG_MY_REMOTE);
+                dnsCache::getInstance().prefetch(CONFIG_MY_LOCAL);
             }
+
+            monitor.tick();
             break;
 
         case wifiStateEnum::ERROR:
-            if (shouldReconnect())
+            if (shouldReconnect() && !expireAttempt())
             {
                 MYLOG("❌ Error in Wifi Initialization. ReInitializing");
-                wifi.connect();
+                startAttempt();
                 atomic_set(&start_time, k_uptime_get());
-                atomic_inc(&connection_attempts);
+                pending = true;
             }
             break;
 
         case wifiStateEnum::DISCONNECTED:
-            if (shouldReconnect())
+            if (shouldReconnect() && !expireAttempt())
             {
                 MYLOG("❌ Wifi Reconnecting");
-                wifi.connect();
+                startAttempt();
                 atomic_set(&start_time, k_uptime_get());
-                atomic_inc(&connection_attempts);
+                pending = true;
             }
             break;
     }
 
+    updateDeadline(new_state, pending);
+    publishState();
+
     k_mutex_unlock(&state_mutex);
 }
 
+int64_t networkManager::nextDeadline()
+{
+    k_mutex_lock(&state_mutex, K_FOREVER);
+    int64_t deadline = next_deadline;
+    k_mutex_unlock(&state_mutex);
+
+    return deadline;
+}
+
+uint32_t networkManager::waitForEvent(int64_t deadline)
+{
+    k_timeout_t timeout = K_FOREVER;
+
+    if (deadline != INT64_MAX)
+    {
+        timeout = K_MSEC(MAX(deadline - k_uptime_get(), 0));
+    }
+
+    uint32_t posted = k_event_wait(&events, EVENT_WIFI | EVENT_REACHABILITY, false, timeout);
+    if (posted != 0)
+    {
+        /* Cleared before the caller ticks, so an event posted meanwhile wakes the next wait */
+        k_event_clear(&events, posted);
+    }
+    return posted;
+}
+
+void networkManager::updateDeadline(wifiStateEnum state, bool pending)
+{
+    int64_t now      = k_uptime_get();
+    int64_t start    = atomic_get(&start_time);
+    int64_t deadline = INT64_MAX;
+
+    switch (state)
+    {
+        case wifiStateEnum::IDLE:
+            deadline = atomic_get(&is_connect_requested) ? (now + WIFI_POLL_MS)
+                                                         : MAX(start + WIFI_START_DELAY + 1, reconnect_at);
+            break;
+
+        case wifiStateEnum::CONNECTING:
+            deadline = MIN(attempt_started + policy.connectTimeout() + 1, now + WIFI_POLL_MS);
+            break;
+
+        case wifiStateEnum::CONNECTED:
+            deadline = monitor.nextProbe();
+            break;
+
+        case wifiStateEnum::ERROR:
+        case wifiStateEnum::DISCONNECTED:
+            deadline = reconnect_at;
+            break;
+    }
+
+    /* The state machine moves one step per update: run again right away */
+    if (pending)
+    {
+        deadline = now;
+    }
+
+    next_deadline = deadline;
+}
+
 /**
  * @brief Get the name of the manager.
  * @return Name of the manager.
@@ -179,64 +266,101 @@ std::string networkManager::getLocalServer()
 }
 
 /**
- * @brief Get if the network is connected to LAN.
- * @return True or False if connected to LAN.
+ * @brief Callback that will be called by linkMonitor when a LAN or WAN probe train completes.
  */
-bool networkManager::isConnectedLAN()
+void networkManager::onLinkResult(linkMonitor::target which, bool reachable, void* ctx)
 {
-    return atomic_get(&is_lan_connected);
+    networkManager* instance = static_cast<networkManager*>(ctx);
+
+    atomic_set((which == linkMonitor::LAN) ? &instance->is_lan_connected : &instance->is_wan_connected, reachable);
+    k_event_post(&instance->events, EVENT_REACHABILITY);
 }
 
-/**
- * @brief Get if the network is connected to WAN.
- * @return True or False if connected to WAN.
- */
-bool networkManager::isConnectedWAN()
+wifiStateEnum networkManager::getNetworkState() const
 {
-    return atomic_get(&is_wan_connected);
+    return static_cast<wifiStateEnum>(atomic_get(&wifi_state));
 }
 
-/**
- * @brief Function to check if the network is up or not.
- * @return True if network is up, false otherwise.
- */
-bool networkManager::isNetworkUp()
+uint32_t networkManager::getConnectionAttempts() const
 {
-    return (static_cast<wifiStateEnum>(atomic_get(&wifi_state)) == wifiStateEnum::CONNECTED);
+    return atomic_get(&connection_attempts);
 }
 
-/**
- * @brief Callback that will be called by pingManager for Local Server Request.
- */
-void networkManager::setIsConnectedLAN(bool value)
+reconnectPolicy& networkManager::getReconnectPolicy()
 {
-    networkManager& instance = getInstance();
-    atomic_set(&instance.is_lan_connected, value);
+    return policy;
 }
 
-/**
- * @brief Callback that will be called by pingManager for Remote Server Request.
- */
-void networkManager::setIsConnectedWAN(bool value)
+void networkManager::handleNetworkStateChange(wifiStateEnum old_state, wifiStateEnum new_state)
 {
-    networkManager& instance = getInstance();
-    atomic_set(&instance.is_wan_connected, value);
+    atomic_set(&wifi_state, static_cast<int>(new_state));
+    MYLOG("Network state changed to: %d", static_cast<int>(new_state));
+
+    /* Probe the LAN and WAN servers only while connected */
+    if (new_state == wifiStateEnum::CONNECTED)
+    {
+        monitor.start(wifi.get_wifi_iface());
+    }
+    else if (old_state == wifiStateEnum::CONNECTED)
+    {
+        monitor.stop();
+        atomic_set(&is_lan_connected, false);
+        atomic_set(&is_wan_connected, false);
+    }
+
+    int64_t now      = k_uptime_get();
+    bool    down     = (new_state == wifiStateEnum::ERROR) || (new_state == wifiStateEnum::DISCONNECTED);
+    bool    was_down = (old_state == wifiStateEnum::ERROR) || (old_state == wifiStateEnum::DISCONNECTED);
+
+    if ((new_state == wifiStateEnum::CONNECTED) && attempt_open)
+    {
+        attempt_open = false;
+        policy.onSuccess(now - attempt_started);
+        reconnectPolicy::stats stats = policy.getStats();
+        MYLOG("📶 Connected in %lld ms (%s policy, %u attempts, %u failures)", now - attempt_started, policy.name(),
+              stats.attempts, stats.failures);
+    }
+    else if (down && (!was_down || attempt_open))
+    {
+        /* A lost connection, or an attempt that ended short of Connected (e.g. Disconnected to Error) */
+        failAttempt(now);
+    }
 }
 
-wifiStateEnum networkManager::getNetworkState() const
+void networkManager::failAttempt(int64_t now)
 {
-    return static_cast<wifiStateEnum>(atomic_get(&wifi_state));
+    if (attempt_open)
+    {
+        attempt_open = false;
+        policy.onFailure(now - attempt_started);
+    }
+
+    uint32_t delay = policy.nextDelay();
+    reconnect_at   = now + delay;
+    MYLOG("⏳ Reconnecting in %u ms (%s policy)", delay, policy.name());
 }
 
-uint32_t networkManager::getConnectionAttempts() const
+bool networkManager::expireAttempt()
 {
-    return atomic_get(&connection_attempts);
+    if (!attempt_open)
+    {
+        return false;
+    }
+
+    MYLOG("❌ Wi-Fi connect attempt ended without connecting");
+    failAttempt(k_uptime_get());
+    return true;
 }
 
-void networkManager::handleNetworkStateChange(wifiStateEnum new_state)
+void networkManager::startAttempt()
 {
-    atomic_set(&wifi_state, static_cast<int>(new_state));
-    MYLOG("Network state changed to: %d", static_cast<int>(new_state));
+    wifi.connect();
+    attempt_started = k_uptime_get();
+    attempt_open    = true;
+    atomic_inc(&connection_attempts);
+
+    /* Guard for a request that never reaches Connecting: retry after the attempt timeout */
+    reconnect_at = attempt_started + policy.connectTimeout();
 }
 
 void networkManager::resetNetworkState()
@@ -247,7 +371,41 @@ void networkManager::resetNetworkState()
     atomic_set(&is_wan_connected, false);
 }
 
+void networkManager::publishState()
+{
+    networkState state = {.wifi = static_cast<wifiStateEnum>(atomic_get(&wifi_state))};
+
+    state.lan = atomic_get(&is_lan_connected);
+    state.wan = atomic_get(&is_wan_connected);
+
+    if (state.isUp())
+    {
+        struct in_addr* addr = net_if_ipv4_get_global_addr(wifi.get_wifi_iface(), NET_ADDR_PREFERRED);
+
+        state.rssi = wifi.getStatus().rssi;
+        state.ipv4 = addr ? *addr : state.ipv4;
+    }
+
+    int  rssi_delta = state.rssi - published.rssi;
+    bool changed    = (state.wifi != published.wifi) || (state.lan != published.lan) ||
+                   (state.wan != published.wan) || (state.ipv4.s_addr != published.ipv4.s_addr) ||
+                   (rssi_delta >= RSSI_STEP_DBM) || (rssi_delta <= -RSSI_STEP_DBM);
+    if (!changed)
+    {
+        return;
+    }
+
+    /* Listeners run here, subscribers are only notified: a failure leaves the change for the next tick */
+    int ret = zbus_chan_pub(&network_state_chan, &state, K_MSEC(PUBLISH_TIMEOUT_MS));
+    if (ret != 0)
+    {
+        MYLOG("❌ Failed to publish network state: %d", ret);
+        return;
+    }
+    published = state;
+}
+
 bool networkManager::shouldReconnect() const
 {
-    return (k_uptime_get() - atomic_get(&start_time) > 10000);
+    return (k_uptime_get() >= reconnect_at);
 }
@@ -22,7 +22,10 @@
 #include "iManager.hpp"
 #include "wifiManager.hpp"
 #include "pingManager.hpp"
+#include "linkMonitor.hpp"
+#include "networkState.hpp"
 #include "portConfig.hpp"
+#include "reconnectPolicy.hpp"
 #include <zephyr/kernel.h>
 #include <zephyr/sys/atomic.h>
 
@@ -33,6 +36,16 @@
 class networkManager : public iManager
 {
   public:
+    /**
+     * @brief Wi-Fi or IPv4 net_mgmt event handled by wifiManager.
+     */
+    static constexpr uint32_t EVENT_WIFI = BIT(0);
+
+    /**
+     * @brief LAN or WAN reachability result from linkMonitor.
+     */
+    static constexpr uint32_t EVENT_REACHABILITY = BIT(1);
+
     /**
      * @brief Get the singleton instance of the networkManager class.
      * @return Reference to the singleton instance.
@@ -57,28 +70,24 @@ class networkManager : public iManager
     const char* name() const override;
 
     /**
-     * @brief Get the address of the local server.
-     * @return std::string name of the local server.
+     * @brief Uptime at which tick() next has timed work to do.
+     * @note Timeouts, reconnect delays and probe trains. Events are not included.
+     * @return Uptime in ms.
      */
-    std::string getLocalServer();
+    int64_t nextDeadline();
 
     /**
-     * @brief Get if the network is connected to LAN.
-     * @return True or False if connected to LAN.
+     * @brief Sleep until a network event is posted or the deadline passes.
+     * @param deadline Uptime in ms, INT64_MAX to wait for events only.
+     * @return Event bits that woke the caller, 0 on timeout. They are cleared.
      */
-    bool isConnectedLAN();
+    uint32_t waitForEvent(int64_t deadline);
 
     /**
-     * @brief Get if the network is connected to WAN.
-     * @return True or False if connected to WAN.
-     */
-    bool isConnectedWAN();
-
-    /**
-     * @brief Function to check if the network is up or not.
-     * @return True if network is up, false otherwise.
+     * @brief Get the address of the local server.
+     * @return std::string name of the local server.
      */
-    bool isNetworkUp();
+    std::string getLocalServer();
 
     /**
      * @brief Get the current network state.
@@ -92,22 +101,50 @@ class networkManager : public iManager
      */
     uint32_t getConnectionAttempts() const;
 
+    /**
+     * @brief Get the reconnect policy in use, with its attempt counters and durations.
+     * @return Reference to the policy selected in Kconfig.
+     */
+    reconnectPolicy& getReconnectPolicy();
+
   private:
     /* Internal Variables */
     struct k_mutex state_mutex;
+    struct k_event events;
     atomic_t       connection_attempts;
 
     /**
-     * @brief Wait time before starting of the Wifi SM
-     * @note This is set to 1500ms
+     * @brief Uptime of the next timed tick() work, written by tick().
      */
-    const uint16_t WIFI_START_DELAY;
+    int64_t next_deadline;
+
+    /**
+     * @brief Status poll period while a Wi-Fi transition is pending
+     * @note Backstop for transitions that raise no net_mgmt event; 0 polls once connected.
+     */
+    static constexpr uint32_t WIFI_POLL_MS = 1000;
+
+    /**
+     * @brief RSSI change in dBm that is published on its own
+     * @note Smaller swings ride along with the next state or reachability change.
+     */
+    static constexpr int8_t RSSI_STEP_DBM = 5;
+
+    /**
+     * @brief Longest tick() waits for a slow subscriber before dropping a publication
+     */
+    static constexpr uint32_t PUBLISH_TIMEOUT_MS = 100;
 
     /**
-     * @brief Wait time for letting Wifi to connect to the network
-     * @note This is set to 120 seconds
+     * @brief Last message published on network_state_chan, written by tick().
      */
-    const uint32_t WIFI_CONNECT_TIMEOUT;
+    networkState published;
+
+    /**
+     * @brief Wait time before starting of the Wifi SM
+     * @note This is set to 1500ms
+     */
+    const uint16_t WIFI_START_DELAY;
 
     /**
      * @brief String Values gotten from build system for LAN Server
@@ -124,10 +161,6 @@ class networkManager : public iManager
      */
     atomic_t start_time;
 
-    /**
-     * @brief For tracking ticks
-     */
-    atomic_t tick_count;
 
     /**
      * @brief Flag to check if the network is requested to connect.
@@ -143,13 +176,13 @@ class networkManager : public iManager
 
     /**
      * @brief Flag to check if the network is connected to LAN or not.
-     * @note This is set to true when the pingManager receives a successful response
+     * @note Set by linkMonitor after each probe train: true if any ping of it was answered
      */
     atomic_t is_lan_connected;
 
     /**
      * @brief Flag to check if the network is connected to WAN or not.
-     * @note This is set to true when the pingManager receives a successful response
+     * @note Set by linkMonitor after each probe train: true if any ping of it was answered
      */
     atomic_t is_wan_connected;
 
@@ -166,6 +199,27 @@ class networkManager : public iManager
     /* PingManager instance pointer */
     pingManager& ping;
 
+    /* Link quality probing of the LAN and WAN servers */
+    linkMonitor& monitor;
+
+    /* Reconnect policy selected in Kconfig */
+    reconnectPolicy& policy;
+
+    /**
+     * @brief Uptime of the current connect request, for the attempt timeout and duration.
+     */
+    int64_t attempt_started;
+
+    /**
+     * @brief An attempt started by startAttempt() has not yet been reported to the policy.
+     */
+    bool attempt_open;
+
+    /**
+     * @brief Uptime from which the next reconnect may start, set by the policy.
+     */
+    int64_t reconnect_at;
+
     /**
      * @brief Private constructor for the singleton pattern.
      */
@@ -182,20 +236,34 @@ class networkManager : public iManager
     networkManager& operator=(const networkManager&) = delete;
 
     /**
-     * @brief Callback that will be called by pingManager for Local Server Request.
+     * @brief Callback that will be called by linkMonitor when a LAN or WAN probe train completes.
      */
-    static void setIsConnectedLAN(bool value);
+    static void onLinkResult(linkMonitor::target which, bool reachable, void* ctx);
 
     /**
-     * @brief Callback that will be called by pingManager for Remote Server Request.
+     * @brief Handle network state changes.
+     * @note Reports attempt outcomes to the reconnect policy and schedules the next attempt.
+     * @param old_state The previous network state.
+     * @param new_state The new network state.
      */
-    static void setIsConnectedWAN(bool value);
+    void handleNetworkStateChange(wifiStateEnum old_state, wifiStateEnum new_state);
 
     /**
-     * @brief Handle network state changes.
-     * @param new_state The new network state.
+     * @brief Issue a connect request and start timing the attempt.
+     */
+    void startAttempt();
+
+    /**
+     * @brief Report the open attempt, if any, as failed and schedule the next one after the policy's delay.
+     */
+    void failAttempt(int64_t now);
+
+    /**
+     * @brief Fail an attempt that reached its timeout while the state stayed down.
+     * @note Catches a rejected request or Error and back to Disconnected within one update.
+     * @return true if an attempt was open; the next one waits for the policy's delay.
      */
-    void handleNetworkStateChange(wifiStateEnum new_state);
+    bool expireAttempt();
 
     /**
      * @brief Reset network state.
@@ -203,7 +271,19 @@ class networkManager : public iManager
     void resetNetworkState();
 
     /**
-     * @brief Check if it's time to reconnect.
+     * @brief Work out when tick() has to run again without an event.
+     * @param state Wi-Fi state after this tick.
+     * @param pending A transition was requested this tick and needs another update.
+     */
+    void updateDeadline(wifiStateEnum state, bool pending);
+
+    /**
+     * @brief Publish the network state on network_state_chan if it changed since the last publication.
+     */
+    void publishState();
+
+    /**
+     * @brief Check if the reconnect policy allows the next attempt.
      * @return true if it's time to reconnect, false otherwise.
      */
     bool shouldReconnect() const;
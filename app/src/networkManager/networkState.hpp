@@ -0,0 +1,49 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2025 Osama Salah-ud-Din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "wifiContext.hpp"
+
+#include <zephyr/net/net_ip.h>
+#include <zephyr/zbus/zbus.h>
+
+/**
+ * @brief Network state published by networkManager on network_state_chan.
+ * @note Published only when a field changes (RSSI with a hysteresis), so subscribers are not woken by noise.
+ *       Consumers subscribe or read the cached message instead of polling the manager.
+ */
+struct networkState
+{
+    wifiStateEnum  wifi;  /**< Wi-Fi state machine state */
+    bool           lan;   /**< Last LAN probe train was answered */
+    bool           wan;   /**< Last WAN probe train was answered */
+    int8_t         rssi;  /**< Signal strength in dBm, 0 when not connected */
+    struct in_addr ipv4;  /**< Preferred IPv4 address, 0.0.0.0 when not connected */
+
+    /**
+     * @brief Wi-Fi is connected with an address, the old isNetworkUp().
+     */
+    bool isUp() const
+    {
+        return (wifi == wifiStateEnum::CONNECTED);
+    }
+};
+
+ZBUS_CHAN_DECLARE(network_state_chan);
@@ -36,4 +36,7 @@ constexpr int PORT_AIR_QUALITY_SENSOR = 50002;
 /* Reserved for future use */
 constexpr int DEBUG_CONSOLE = 50050;
 
+/* Periodic socket statistics (UDP) */
+constexpr int STATS_CONSOLE = 50051;
+
 } // namespace portConfig
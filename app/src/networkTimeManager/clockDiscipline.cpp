@@ -0,0 +1,228 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2025 Osama Salah-ud-Din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "clockDiscipline.hpp"
+
+/* Frequency corrections apply half of each measured drift: damps the noise of a single sync */
+#define FREQ_GAIN_SHIFT (1)
+
+clockDiscipline::clockDiscipline()
+{
+    reset();
+}
+
+uint64_t clockDiscipline::captureCycles()
+{
+#if defined(CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER)
+    return k_cycle_get_64();
+#else
+    /* The 32-bit cycle counter wraps within seconds, the tick counter does not */
+    return k_ticks_to_cyc_floor64(k_uptime_ticks());
+#endif
+}
+
+int64_t clockDiscipline::cyclesToLocalUs(uint64_t cycles)
+{
+    return (int64_t)k_cyc_to_us_floor64(cycles);
+}
+
+int64_t clockDiscipline::localUs()
+{
+    return cyclesToLocalUs(captureCycles());
+}
+
+bool clockDiscipline::isSynced() const
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    bool             ret = synced;
+    k_spin_unlock(&lock, key);
+
+    return ret;
+}
+
+int64_t clockDiscipline::slewedScaled(int64_t elapsed_us) const
+{
+    /* A capture from before the last measurement: the slew had not started yet */
+    if (elapsed_us <= 0)
+    {
+        return 0;
+    }
+
+    /* Slews are smaller than STEP_THRESHOLD_US, so the largest is done by this time: bounding the elapsed time here
+     * keeps the budget from overflowing after months without a sync */
+    int64_t elapsed = MIN(elapsed_us, (STEP_THRESHOLD_US * 1000000) / SLEW_PPM);
+    int64_t budget  = elapsed * SLEW_PPM * 1000;
+    int64_t target  = slew_us * 1000000000;
+
+    return (target >= 0) ? MIN(target, budget) : MAX(target, -budget);
+}
+
+int64_t clockDiscipline::epochLocked(int64_t local_us) const
+{
+    if (!synced)
+    {
+        return 0;
+    }
+
+    int64_t elapsed = local_us - base_local_us;
+
+    /* elapsed * freq_ppb would overflow after about 213 days without a sync: the whole seconds give whole
+     * nanoseconds, whose whole microseconds are taken out first */
+    int64_t seconds_ns = (elapsed / 1000000) * freq_ppb;
+    int64_t whole_us   = seconds_ns / 1000;
+
+    /* The rest is summed before rounding: rounded apart, both terms could lose a microsecond at the same tick
+     * and the model would run backwards while slewing back on a negative frequency error. Floored, so the
+     * result does not depend on how the whole microseconds were split off */
+    int64_t correction = ((seconds_ns - (whole_us * 1000)) * 1000000) + ((elapsed % 1000000) * freq_ppb) +
+                         slewedScaled(elapsed);
+    int64_t rest_us    = (correction / 1000000000) - (((correction % 1000000000) < 0) ? 1 : 0);
+
+    return base_epoch_us + elapsed + whole_us + rest_us;
+}
+
+int64_t clockDiscipline::epochUs(int64_t local_us) const
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    int64_t          ret = epochLocked(local_us);
+    k_spin_unlock(&lock, key);
+
+    return ret;
+}
+
+int64_t clockDiscipline::nowUs() const
+{
+    return epochUs(localUs());
+}
+
+void clockDiscipline::step(int64_t server_us, int64_t local_us)
+{
+    base_local_us = local_us;
+    base_epoch_us = server_us;
+    slew_us       = 0;
+    synced        = true;
+    stable        = 0;
+    interval_s    = CONFIG_APP_SNTP_MIN_INTERVAL;
+    steps++;
+}
+
+clockDiscipline::correction clockDiscipline::update(int64_t server_us, int64_t local_us)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    failed = false;
+
+    if (!synced)
+    {
+        offset_us = 0;
+        step(server_us, local_us);
+        k_spin_unlock(&lock, key);
+        return correction::STEP;
+    }
+
+    int64_t elapsed   = local_us - base_local_us;
+    int64_t model     = epochLocked(local_us);
+    int64_t remaining = slew_us - (slewedScaled(elapsed) / 1000000000);
+
+    offset_us = server_us - model;
+
+    /* The frequency estimate survives a step, only the phase is reset */
+    if ((offset_us > STEP_THRESHOLD_US) || (offset_us < -STEP_THRESHOLD_US))
+    {
+        step(server_us, local_us);
+        k_spin_unlock(&lock, key);
+        return correction::STEP;
+    }
+
+    /* What the unfinished slew does not explain accumulated from the frequency error */
+    if (elapsed >= (CONFIG_APP_SNTP_MIN_INTERVAL * USEC_PER_SEC) / 2)
+    {
+        int64_t drift_ppb = ((offset_us - remaining) * 1000000000) / elapsed;
+
+        freq_ppb = CLAMP(freq_ppb + (int32_t)(drift_ppb >> FREQ_GAIN_SHIFT), -MAX_FREQ_PPB, MAX_FREQ_PPB);
+    }
+
+    /* Rebase on the model, not the server: time stays continuous and the offset is slewed out */
+    base_local_us = local_us;
+    base_epoch_us = model;
+    slew_us       = offset_us;
+    slews++;
+
+    if ((offset_us <= STABLE_OFFSET_US) && (offset_us >= -STABLE_OFFSET_US))
+    {
+        if (++stable >= STABLE_SYNCS)
+        {
+            interval_s = MIN(interval_s * 2, (uint32_t)CONFIG_APP_SNTP_MAX_INTERVAL);
+            stable     = 0;
+        }
+    }
+    else
+    {
+        interval_s = MAX(interval_s / 2, (uint32_t)CONFIG_APP_SNTP_MIN_INTERVAL);
+        stable     = 0;
+    }
+
+    k_spin_unlock(&lock, key);
+    return correction::SLEW;
+}
+
+void clockDiscipline::onFailure()
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    failed               = true;
+    stable               = 0;
+    k_spin_unlock(&lock, key);
+}
+
+uint32_t clockDiscipline::nextIntervalMs() const
+{
+    k_spinlock_key_t key      = k_spin_lock(&lock);
+    uint32_t         interval = failed ? CONFIG_APP_SNTP_MIN_INTERVAL : interval_s;
+    k_spin_unlock(&lock, key);
+
+    return interval * MSEC_PER_SEC;
+}
+
+clockDiscipline::stats clockDiscipline::getStats() const
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    stats            s   = {synced, offset_us, freq_ppb, interval_s, steps, slews};
+    k_spin_unlock(&lock, key);
+
+    return s;
+}
+
+void clockDiscipline::reset()
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    synced        = false;
+    failed        = false;
+    stable        = 0;
+    base_local_us = 0;
+    base_epoch_us = 0;
+    slew_us       = 0;
+    freq_ppb      = 0;
+    offset_us     = 0;
+    interval_s    = CONFIG_APP_SNTP_MIN_INTERVAL;
+    steps         = 0;
+    slews         = 0;
+
+    k_spin_unlock(&lock, key);
+}
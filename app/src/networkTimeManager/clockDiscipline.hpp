@@ -0,0 +1,177 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2025 Osama Salah-ud-Din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <zephyr/kernel.h>
+
+/**
+ * @class clockDiscipline
+ * @brief Epoch time model fed by SNTP measurements.
+ *
+ * Between syncs the epoch time is extrapolated from the cycle counter, corrected by an
+ * estimate of the oscillator frequency error that each sync refines. Offsets up to
+ * STEP_THRESHOLD_US are slewed out at SLEW_PPM so time never jumps or runs backwards;
+ * larger ones (and the first sync) step the clock. The sync interval doubles after
+ * STABLE_SYNCS small offsets, up to CONFIG_APP_SNTP_MAX_INTERVAL, and drops back towards
+ * CONFIG_APP_SNTP_MIN_INTERVAL on large offsets and failed syncs.
+ */
+class clockDiscipline
+{
+  public:
+    /**
+     * @brief How a measurement was applied.
+     */
+    enum class correction : uint8_t
+    {
+        STEP, /**< Clock set to the server time */
+        SLEW, /**< Offset spread over the following interval */
+    };
+
+    /**
+     * @brief State of the model, for logs and the shell.
+     */
+    struct stats
+    {
+        bool     synced;     /**< At least one measurement applied */
+        int64_t  offset_us;  /**< Offset measured by the last sync, server minus model */
+        int32_t  freq_ppb;   /**< Estimated frequency error, positive when the local clock runs slow */
+        uint32_t interval_s; /**< Current sync interval */
+        uint32_t steps;      /**< Measurements that stepped the clock */
+        uint32_t slews;      /**< Measurements that were slewed */
+    };
+
+    /**
+     * @brief Offset above which the clock is stepped instead of slewed.
+     */
+    static constexpr int64_t STEP_THRESHOLD_US = 128000;
+
+    /**
+     * @brief Offset up to which a sync counts as stable.
+     * @note Above the usual Wi-Fi path asymmetry, so stable links reach the long interval.
+     */
+    static constexpr int64_t STABLE_OFFSET_US = 20000;
+
+    /**
+     * @brief Consecutive stable syncs that double the interval.
+     */
+    static constexpr uint8_t STABLE_SYNCS = 2;
+
+    /**
+     * @brief Rate at which an offset is slewed out, in ppm of elapsed time.
+     */
+    static constexpr int64_t SLEW_PPM = 500;
+
+    /**
+     * @brief Largest frequency error the estimate may reach, in ppb.
+     */
+    static constexpr int32_t MAX_FREQ_PPB = 500000;
+
+    clockDiscipline();
+
+    /**
+     * @brief Capture the local time base, cheap enough to take right at a sensor read.
+     * @note The 64-bit cycle counter, or the tick counter in cycles where the timer has no 64-bit counter.
+     * @return Cycles since boot.
+     */
+    static uint64_t captureCycles();
+
+    /**
+     * @brief Convert a capture to the local time of the model.
+     * @param cycles Value from captureCycles().
+     * @return Local time in microseconds.
+     */
+    static int64_t cyclesToLocalUs(uint64_t cycles);
+
+    /**
+     * @brief Local time base of the model: time since boot in microseconds, from captureCycles().
+     */
+    static int64_t localUs();
+
+    /**
+     * @brief Whether a measurement has been applied since the last reset().
+     */
+    bool isSynced() const;
+
+    /**
+     * @brief Epoch time in microseconds at a local time.
+     * @param local_us Local time from localUs().
+     * @return Epoch microseconds, 0 when not synced.
+     */
+    int64_t epochUs(int64_t local_us) const;
+
+    /**
+     * @brief Epoch time in microseconds now, 0 when not synced.
+     */
+    int64_t nowUs() const;
+
+    /**
+     * @brief Apply one measurement of the server time.
+     * @param server_us Server epoch time in microseconds, RTT corrected.
+     * @param local_us Local time at which it was valid.
+     * @return Whether the clock was stepped or slewed.
+     */
+    correction update(int64_t server_us, int64_t local_us);
+
+    /**
+     * @brief A sync failed: the next one runs after the shortest interval.
+     * @note The model keeps running on its frequency estimate.
+     */
+    void onFailure();
+
+    /**
+     * @brief Delay until the next sync.
+     * @return Milliseconds.
+     */
+    uint32_t nextIntervalMs() const;
+
+    /**
+     * @brief Snapshot of the model.
+     */
+    stats getStats() const;
+
+    /**
+     * @brief Forget the time and the frequency estimate.
+     */
+    void reset();
+
+  private:
+    mutable struct k_spinlock lock;
+
+    bool     synced;
+    bool     failed;
+    uint8_t  stable;
+    int64_t  base_local_us; /**< Local time of the last measurement */
+    int64_t  base_epoch_us; /**< Model time at base_local_us */
+    int64_t  slew_us;       /**< Offset being slewed out since base_local_us */
+    int32_t  freq_ppb;
+    int64_t  offset_us;
+    uint32_t interval_s;
+    uint32_t steps;
+    uint32_t slews;
+
+    /**
+     * @brief Part of slew_us applied after elapsed_us of local time, in units of 1e-9 us.
+     * @note The scale of elapsed_us * freq_ppb, so both corrections are rounded once, together.
+     */
+    int64_t slewedScaled(int64_t elapsed_us) const;
+
+    int64_t epochLocked(int64_t local_us) const;
+    void    step(int64_t server_us, int64_t local_us);
+};
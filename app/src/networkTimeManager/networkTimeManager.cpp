@@ -20,29 +20,106 @@
 #include "networkTimeManager.hpp"
 
 #include "myLogger.hpp"
+#include "networkState.hpp"
+#include "dnsCache.hpp"
+#include "sntpSelection.hpp"
+#include "socketManager.hpp"
 
-#include <zephyr/net/sntp.h>
 #include <zephyr/net/net_ip.h>
+#include <zephyr/net/socket.h>
 #include <zephyr/posix/time.h>
 #include <zephyr/kernel.h>
+#include <zephyr/random/random.h>
+#include <zephyr/shell/shell.h>
 #include <zephyr/sys/atomic.h>
+#include <unistd.h>
+#include <cerrno>
 #include <cstring>
 
+/* Seconds from the NTP era 0 epoch (1900) to the Unix epoch (1970) */
+#define SNTP_UNIX_EPOCH_OFFSET (2208988800UL)
+
+/* LI 0, version 4, mode 3 (client) */
+#define SNTP_VERSION_CLIENT ((4 << 3) | 3)
+
+#define SNTP_MODE_MASK (0x07)
+#define SNTP_MODE_SERVER (4)
+
+/* Root delay and dispersion are unsigned 16.16 fixed point seconds */
+#define SNTP_SHORT_TO_US(v) ((uint32_t)(((uint64_t)ntohl(v) * USEC_PER_SEC) >> 16))
+
+/* Full 32.32 fixed point NTP timestamp to Unix epoch microseconds */
+#define SNTP_TIMESTAMP_TO_US(s, f)                                                                                     \
+    (((int64_t)(uint32_t)(ntohl(s) - SNTP_UNIX_EPOCH_OFFSET) * USEC_PER_SEC) +                                         \
+     (int64_t)(((uint64_t)ntohl(f) * USEC_PER_SEC) >> 32))
+
+/* Separators of CONFIG_APP_SNTP_SERVERS */
+#define SNTP_SERVER_SEPARATORS " ,"
+
+/**
+ * @brief SNTP packet (RFC 4330), all fields in network byte order.
+ */
+struct sntpPacket
+{
+    uint8_t  li_vn_mode;
+    uint8_t  stratum;
+    uint8_t  poll;
+    int8_t   precision;
+    uint32_t root_delay;
+    uint32_t root_dispersion;
+    uint32_t ref_id;
+    uint32_t ref_tm_s;
+    uint32_t ref_tm_f;
+    uint32_t orig_tm_s;
+    uint32_t orig_tm_f;
+    uint32_t rx_tm_s;
+    uint32_t rx_tm_f;
+    uint32_t tx_tm_s;
+    uint32_t tx_tm_f;
+} __packed;
+
+ZBUS_CHAN_DEFINE(time_sync_chan, timeSyncResult, NULL, NULL, ZBUS_OBSERVERS_EMPTY, ZBUS_MSG_INIT(0));
+
+/* Syncs follow WAN reachability, nothing has to poll for it */
+ZBUS_LISTENER_DEFINE(ntp_network_lis, networkTimeManager::network_state_listener);
+ZBUS_CHAN_ADD_OBS(network_state_chan, ntp_network_lis, 2);
+
+static_assert(networkTimeManager::MAX_SERVERS <= sntpSelection::MAX_SAMPLES, "every answer must fit a selection");
+
 /* Initialize static members */
 struct k_mutex      networkTimeManager::instance_mutex;
 networkTimeManager* networkTimeManager::instance = nullptr;
 
-networkTimeManager::networkTimeManager() : SYNC_INTERVAL(3600000), SNTP_SERVER("5.9.19.62")
+networkTimeManager::networkTimeManager()
 {
+    const std::string list  = CONFIG_APP_SNTP_SERVERS;
+    size_t            start = list.find_first_not_of(SNTP_SERVER_SEPARATORS);
+
+    while ((start != std::string::npos) && (server_count < MAX_SERVERS))
+    {
+        size_t      end  = list.find_first_of(SNTP_SERVER_SEPARATORS, start);
+        std::string host = list.substr(start, end - start);
+
+        if (validate_server(host.c_str()))
+        {
+            server& entry    = servers[server_count++];
+            entry            = {};
+            entry.host       = host;
+            entry.stats.host = entry.host.c_str();
+        }
+        start = list.find_first_not_of(SNTP_SERVER_SEPARATORS, end);
+    }
+
     k_mutex_init(&state_mutex);
     k_mutex_init(&time_mutex);
     atomic_set(&sync_attempts, 0);
     atomic_set(&last_sync_error, 0);
     atomic_set(&is_syncing, false);
     atomic_set(&is_sync_active, false);
-    atomic_set(&synced, false);
-    atomic_set(&synced_time, 0);
-    atomic_set(&last_uptime, 0);
+    atomic_set(&utc_offset_ms, 0);
+    atomic_set(&wan_up, false);
+    atomic_set(&sync_requested, false);
+    k_work_init_delayable(&sync_work, sync_work_handler);
 }
 
 networkTimeManager& networkTimeManager::getInstance()
@@ -61,9 +138,6 @@ bool networkTimeManager::init()
 {
     k_mutex_init(&state_mutex);
     k_mutex_init(&instance_mutex);
-    atomic_set(&synced, false);
-    atomic_set(&last_uptime, 0);
-    atomic_set(&synced_time, 0);
     reset_state();
     MYLOG("Network Time Manager initialized");
     return true;
@@ -76,7 +150,7 @@ const char* networkTimeManager::name() const
 
 void networkTimeManager::tick()
 {
-    sync(SNTP_SERVER.c_str(), 5000);
+    startSync();
 }
 
 void networkTimeManager::cleanup()
@@ -88,9 +162,8 @@ void networkTimeManager::cleanup()
 
 void networkTimeManager::reset_state()
 {
-    atomic_set(&synced, false);
-    atomic_set(&last_uptime, 0);
-    atomic_set(&synced_time, 0);
+    clock.reset();
+    atomic_set(&utc_offset_ms, 0);
 }
 
 bool networkTimeManager::validate_server(const char* server)
@@ -103,118 +176,419 @@ bool networkTimeManager::validate_server(const char* server)
     return true;
 }
 
-void networkTimeManager::handle_error(const char* operation, int error_code)
+void networkTimeManager::sync_work_handler(struct k_work* work)
 {
-    MYLOG("Error in %s: %d", operation, error_code);
-    cleanup();
+    ARG_UNUSED(work);
+    networkTimeManager& self = getInstance();
+
+    k_mutex_lock(&self.state_mutex, K_FOREVER);
+
+    /* Not syncing: this is the scheduled sync, or a run queued before the last sync finished */
+    if (!atomic_get(&self.is_syncing))
+    {
+        bool requested = atomic_cas(&self.sync_requested, true, false);
+        bool due       = requested || (k_uptime_get() >= self.next_sync_at);
+
+        /* While the WAN is down nothing is rescheduled, the listener restarts syncing */
+        if (!due || !atomic_get(&self.wan_up))
+        {
+            k_mutex_unlock(&self.state_mutex);
+            return;
+        }
+        atomic_set(&self.is_syncing, true);
+    }
+
+    if (self.awaiting)
+    {
+        bool any = false;
+
+        self.awaiting = false;
+        for (size_t i = 0; i < self.server_count; i++)
+        {
+            server& s = self.servers[i];
+            any       = any || s.answered;
+
+            /* The next lookup moves on to another address of that pool */
+            if (s.pending)
+            {
+                s.pending = false;
+                dnsCache::getInstance().reportFailure(s.host, s.addr);
+                MYLOG("SNTP request %u to %s timed out", self.attempt, s.host.c_str());
+            }
+        }
+
+        /* The servers that did answer are enough */
+        if (any)
+        {
+            self.complete();
+        }
+        else
+        {
+            self.retry_or_fail(-ETIMEDOUT);
+        }
+    }
+    else
+    {
+        int ret = self.send_requests();
+        if (ret < 0)
+        {
+            self.retry_or_fail(ret);
+        }
+    }
+
+    k_mutex_unlock(&self.state_mutex);
 }
 
-bool networkTimeManager::perform_sync(const char* server, int timeout_ms)
+int networkTimeManager::send_requests()
 {
-    struct sntp_ctx ctx = {};
-    int             ret;
+    int ret  = -EAGAIN;
+    int sent = 0;
+
+    attempt++;
+    atomic_inc(&sync_attempts);
 
-    /* Initialize address structure */
-    struct sockaddr_in addr = {};
-    addr.sin_family         = AF_INET;
-    addr.sin_port           = htons(SNTP_PORT);
+    if (sock < 0)
+    {
+        /* One unconnected socket for all servers, replies are matched by source address and cookie */
+        sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (sock < 0)
+        {
+            return -errno;
+        }
 
-    struct sntp_time sntpTime;
+        if (!socketManager::getInstance().watchFd(sock, on_readable, this))
+        {
+            close(sock);
+            sock = -1;
+            return -ENOMEM;
+        }
+    }
 
-    /* Convert server address */
-    ret = inet_pton(AF_INET, server, &addr.sin_addr);
-    if (ret != 1)
+    for (size_t i = 0; i < server_count; i++)
     {
-        handle_error("inet_pton", ret);
-        return false;
+        server&         s = servers[i];
+        struct sockaddr addrs[dnsCache::MAX_CANDIDATES];
+        socklen_t       addrlens[dnsCache::MAX_CANDIDATES];
+
+        s.answered = false;
+        s.pending  = false;
+
+        /* Resolve through the shared cache, a pending lookup skips the server this round */
+        int count = dnsCache::getInstance().candidates(s.host, SNTP_PORT, addrs, addrlens);
+        int found = -1;
+        for (int j = 0; j < count; j++)
+        {
+            found = ((found < 0) && (addrs[j].sa_family == AF_INET)) ? j : found;
+        }
+
+        if (found < 0)
+        {
+            ret = (count < 0) ? count : -EAFNOSUPPORT;
+            continue;
+        }
+
+        /* Client mode, the reply echoes our transmit timestamp as its originate timestamp */
+        struct sntpPacket request = {};
+        request.li_vn_mode        = SNTP_VERSION_CLIENT;
+        s.addr                    = addrs[found];
+        s.cookie                  = sys_rand32_get();
+        request.tx_tm_f           = htonl(s.cookie);
+        s.sent_us                 = clockDiscipline::localUs();
+
+        if (sendto(sock, &request, sizeof(request), MSG_DONTWAIT, &s.addr, addrlens[found]) < 0)
+        {
+            ret = -errno;
+            continue;
+        }
+
+        /* Shifted in as a miss, a usable answer sets the bit */
+        s.pending     = true;
+        s.stats.reach = s.stats.reach << 1;
+        s.stats.sent++;
+        sent++;
     }
 
-    /* Initialize SNTP context */
-    ret = sntp_init(&ctx, (struct sockaddr*) &addr, sizeof(struct sockaddr_in));
-    if (ret < 0)
+    if (sent == 0)
     {
-        handle_error("sntp_init", ret);
-        return false;
+        return ret;
     }
 
-    /* Query SNTP server */
-    ret = sntp_query(&ctx, timeout_ms, &sntpTime);
-    if (ret < 0)
+    awaiting = true;
+    k_work_reschedule(&sync_work, K_MSEC(SYNC_TIMEOUT));
+    return 0;
+}
+
+size_t networkTimeManager::select_server(uint8_t& rejected)
+{
+    size_t                answered[MAX_SERVERS];
+    sntpSelection::sample samples[MAX_SERVERS];
+    size_t                n = 0;
+
+    for (size_t i = 0; i < server_count; i++)
     {
-        handle_error("sntp_query", ret);
-        sntp_close(&ctx);
-        return false;
+        const server& s = servers[i];
+        if (s.answered)
+        {
+            samples[n]    = {s.server_us - s.local_us, s.distance_us, s.stats.reach, s.stats.rtt_us, false};
+            answered[n++] = i;
+        }
     }
 
-    /* Update state with new time */
-    k_mutex_lock(&state_mutex, K_FOREVER);
-    atomic_set(&synced, true);
-    atomic_set(&last_uptime, k_uptime_get());
+    size_t selected = sntpSelection::select(samples, n);
 
-    /* Log successful sync */
-    struct tm time_info;
-    time_t    time = sntpTime.seconds;
-    gmtime_r(&time, &time_info);
+    rejected = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        server& s = servers[answered[i]];
+        if (samples[i].falseticker)
+        {
+            s.stats.reach &= ~1U;
+            s.stats.falsetickers++;
+            rejected++;
+            MYLOG("⏰ %s rejected as falseticker, offset %lld us", s.host.c_str(), (long long)samples[i].offset_us);
+        }
+    }
+
+    return answered[selected];
+}
+
+void networkTimeManager::complete()
+{
+    uint8_t rejected = 0;
+    server& s        = servers[select_server(rejected)];
+
+    s.stats.selected++;
+    MYLOG("⏰ Using %s, %u us RTT, ±%u us", s.host.c_str(), s.rtt_us, s.distance_us);
+
+    k_work_cancel_delayable(&sync_work);
+    int64_t offset_us = apply_time(s.server_us, s.local_us);
+    atomic_set(&last_sync_error, 0);
+    finish(0, s.rtt_us / USEC_PER_MSEC, offset_us, rejected);
+}
+
+void networkTimeManager::retry_or_fail(int error)
+{
+    atomic_set(&last_sync_error, error);
+
+    if (attempt < MAX_RETRIES)
+    {
+        /* The retry is a timer, nothing sleeps in between */
+        k_work_reschedule(&sync_work, K_MSEC(RETRY_DELAY));
+        return;
+    }
+
+    /* The clock keeps running on its frequency estimate until a sync succeeds */
+    clock.onFailure();
+    finish(error, 0, 0, 0);
+}
+
+void networkTimeManager::finish(int error, uint32_t rtt_ms, int64_t offset_us, uint8_t rejected)
+{
+    uint8_t answered = 0;
+    for (size_t i = 0; i < server_count; i++)
+    {
+        answered += servers[i].answered ? 1 : 0;
+        servers[i].pending = false;
+    }
+
+    timeSyncResult result   = {error, attempt, answered, rejected, rtt_ms, offset_us, k_uptime_get()};
+    uint32_t       interval = clock.nextIntervalMs();
+
+    if (sock >= 0)
+    {
+        socketManager::getInstance().unwatchFd(sock);
+        close(sock);
+        sock = -1;
+    }
+
+    awaiting = false;
+    attempt  = 0;
+    atomic_set(&is_syncing, false);
 
-    if ((time_info.tm_mon + 1 > 3) && (time_info.tm_mon + 1 < 11))
+    if (error == 0)
     {
-        /* Daylight Savings Time */
-        atomic_set(&synced_time, ((((time_info.tm_hour + 2) % 24) * SEC_PER_HOUR) + (time_info.tm_min * SEC_PER_MIN) +
-                                  time_info.tm_sec) *
-                                     MSEC_PER_SEC);
+        MYLOG("⏰ Time synced in %u rounds, %u/%u servers answered, %u rejected, %u ms RTT, next sync in %u s",
+              result.attempts, answered, server_count, rejected, rtt_ms, interval / MSEC_PER_SEC);
     }
     else
     {
-        atomic_set(&synced_time, (((((time_info.tm_hour + 1)) % 24) * SEC_PER_HOUR) + (time_info.tm_min * SEC_PER_MIN) +
-                                  time_info.tm_sec) *
-                                     MSEC_PER_SEC);
+        MYLOG("⏰ Time sync failed after %u rounds: %d, next sync in %u s", result.attempts, error,
+              interval / MSEC_PER_SEC);
+    }
+
+    next_sync_at = k_uptime_get() + interval;
+    k_work_reschedule(&sync_work, K_MSEC(interval));
+
+    /* Subscribers only get a notification, so this does not wait on them */
+    zbus_chan_pub(&time_sync_chan, &result, K_NO_WAIT);
+}
+
+void networkTimeManager::on_readable(int fd, void* ctx)
+{
+    ARG_UNUSED(fd);
+    static_cast<networkTimeManager*>(ctx)->handle_reply();
+}
+
+void networkTimeManager::handle_reply()
+{
+    struct sntpPacket  reply;
+    struct sockaddr_in peer;
+    socklen_t          peerlen = sizeof(peer);
+
+    k_mutex_lock(&state_mutex, K_FOREVER);
+
+    ssize_t len = (sock >= 0) ? recvfrom(sock, &reply, sizeof(reply), MSG_DONTWAIT,
+                                         reinterpret_cast<struct sockaddr*>(&peer), &peerlen)
+                              : -1;
+    if ((len < (ssize_t)sizeof(reply)) || !awaiting)
+    {
+        k_mutex_unlock(&state_mutex);
+        return;
+    }
+
+    /* Only the server a request went to, echoing that request's cookie */
+    server* from = nullptr;
+    for (size_t i = 0; (i < server_count) && !from; i++)
+    {
+        server&             s    = servers[i];
+        struct sockaddr_in* addr = reinterpret_cast<struct sockaddr_in*>(&s.addr);
+
+        bool match = s.pending && (addr->sin_addr.s_addr == peer.sin_addr.s_addr) &&
+                     (addr->sin_port == peer.sin_port) && (ntohl(reply.orig_tm_f) == s.cookie);
+        from = match ? &s : nullptr;
+    }
+
+    /* Stale replies to an earlier attempt and kiss-o'-death packets (stratum 0) are dropped */
+    uint8_t mode = reply.li_vn_mode & SNTP_MODE_MASK;
+    if (!from || (mode != SNTP_MODE_SERVER) || (reply.stratum == 0) || (reply.rx_tm_s == 0) ||
+        (reply.tx_tm_s == 0))
+    {
+        k_mutex_unlock(&state_mutex);
+        return;
     }
 
-    MYLOG("Time synced: %04d-%02d-%02d %02d:%02d:%02d", time_info.tm_year + 1900, time_info.tm_mon + 1,
-          time_info.tm_mday, time_info.tm_hour, time_info.tm_min, time_info.tm_sec);
+    /* T1 and T4 are local times, T2 and T3 the server's receive and transmit times: the time the server held the
+     * request is not part of the path delay, and the offset is the mean of both legs' (RFC 4330) */
+    int64_t t1    = from->sent_us;
+    int64_t t2    = SNTP_TIMESTAMP_TO_US(reply.rx_tm_s, reply.rx_tm_f);
+    int64_t t3    = SNTP_TIMESTAMP_TO_US(reply.tx_tm_s, reply.tx_tm_f);
+    int64_t t4    = clockDiscipline::localUs();
+    int64_t delay = (t4 - t1) - (t3 - t2);
+
+    from->local_us    = t4;
+    from->server_us   = t4 + (((t2 - t1) + (t3 - t4)) / 2);
+    from->rtt_us      = (uint32_t)MAX(delay, 0);
+    from->distance_us = (from->rtt_us / 2) + (SNTP_SHORT_TO_US(reply.root_delay) / 2) +
+                        SNTP_SHORT_TO_US(reply.root_dispersion);
+    from->pending     = false;
+    from->answered    = true;
+
+    serverStats& stats = from->stats;
+    int32_t      error = (int32_t)from->rtt_us - (int32_t)stats.rtt_us;
+    stats.rtt_us       = (stats.answered == 0) ? from->rtt_us : stats.rtt_us + (error >> RTT_GAIN_SHIFT);
+    stats.reach       |= 1U;
+    stats.answered++;
+
+    /* Done as soon as every server that was asked has answered */
+    bool pending = false;
+    for (size_t i = 0; i < server_count; i++)
+    {
+        pending = pending || servers[i].pending;
+    }
+
+    if (!pending)
+    {
+        complete();
+    }
 
     k_mutex_unlock(&state_mutex);
+}
 
-    sntp_close(&ctx);
-    return true;
+int64_t networkTimeManager::apply_time(int64_t server_us, int64_t local_us)
+{
+    clockDiscipline::correction how   = clock.update(server_us, local_us);
+    clockDiscipline::stats      stats = clock.getStats();
+
+    struct tm time_info;
+    time_t    seconds = server_us / USEC_PER_SEC;
+    gmtime_r(&seconds, &time_info);
+
+    /* UTC+1, with Daylight Savings Time from April to October */
+    int hours = ((time_info.tm_mon + 1 > 3) && (time_info.tm_mon + 1 < 11)) ? 2 : 1;
+    atomic_set(&utc_offset_ms, hours * SEC_PER_HOUR * MSEC_PER_SEC);
+
+    MYLOG("Time synced: %04d-%02d-%02d %02d:%02d:%02d, %s %lld us, frequency %d ppb", time_info.tm_year + 1900,
+          time_info.tm_mon + 1, time_info.tm_mday, time_info.tm_hour, time_info.tm_min, time_info.tm_sec,
+          (how == clockDiscipline::correction::STEP) ? "stepped" : "slewing", (long long)stats.offset_us,
+          stats.freq_ppb);
+
+    return stats.offset_us;
 }
 
-bool networkTimeManager::sync(const char* server, int timeout_ms)
+void networkTimeManager::network_state_listener(const struct zbus_channel* chan)
 {
-    /* Validate input */
-    if (!validate_server(server))
+    const networkState* state = static_cast<const networkState*>(zbus_chan_const_msg(chan));
+
+    /* No locking or logging in the publisher's context: flags and a work item only. getInstance() takes
+     * instance_mutex, so the pointer is read directly; before the manager exists there is nothing to wake */
+    networkTimeManager* self = instance;
+    if (!self)
     {
-        return false;
+        return;
     }
 
-    /* Set default timeout if invalid */
-    if (timeout_ms <= 0)
+    bool was_up = atomic_set(&self->wan_up, state->wan);
+    if (state->wan && !was_up)
     {
-        timeout_ms = SYNC_TIMEOUT;
+        /* Leaves a pending timeout or retry alone */
+        atomic_set(&self->sync_requested, true);
+        k_work_schedule(&self->sync_work, K_NO_WAIT);
     }
+}
+
+clockDiscipline::stats networkTimeManager::getClockStats() const
+{
+    return clock.getStats();
+}
+
+size_t networkTimeManager::getServerStats(serverStats* out, size_t max)
+{
+    k_mutex_lock(&state_mutex, K_FOREVER);
 
-    /* Attempt sync with retries */
-    int retry_count = 0;
-    while (retry_count < MAX_RETRIES)
+    size_t count = MIN(max, server_count);
+    for (size_t i = 0; i < count; i++)
     {
-        if (perform_sync(server, timeout_ms))
-        {
-            return true;
-        }
-        retry_count++;
+        out[i] = servers[i].stats;
+    }
 
-        if (retry_count < MAX_RETRIES)
-        {
-            k_sleep(K_MSEC(RETRY_DELAY));
-        }
+    k_mutex_unlock(&state_mutex);
+    return count;
+}
+
+bool networkTimeManager::startSync()
+{
+    if (server_count == 0)
+    {
+        MYLOG("No SNTP server configured");
+        return false;
+    }
+
+    k_mutex_lock(&state_mutex, K_FOREVER);
+
+    bool idle = !atomic_get(&is_syncing);
+    if (idle)
+    {
+        atomic_set(&is_syncing, true);
+        k_work_reschedule(&sync_work, K_NO_WAIT);
     }
 
-    return false;
+    k_mutex_unlock(&state_mutex);
+    return idle;
 }
 
 bool networkTimeManager::is_synced() const
 {
-    return atomic_get(&synced);
+    return clock.isSynced();
 }
 
 int64_t networkTimeManager::get_network_time() const
@@ -224,7 +598,44 @@ int64_t networkTimeManager::get_network_time() const
         return 0;
     }
 
-    return atomic_get(&synced_time) + (k_uptime_get() - atomic_get(&last_uptime));
+    /* Local time of day, for the log prefix */
+    int64_t local_ms = (clock.nowUs() / USEC_PER_MSEC) + atomic_get(&utc_offset_ms);
+    return local_ms % (MSEC_PER_SEC * SEC_PER_DAY);
+}
+
+int64_t networkTimeManager::getCurrentTimeUs() const
+{
+    return clock.nowUs();
+}
+
+int64_t networkTimeManager::toEpochUs(uint64_t cycles) const
+{
+    return clock.epochUs(clockDiscipline::cyclesToLocalUs(cycles));
+}
+
+int64_t networkTimeManager::getCurrentTimeMs() const
+{
+    return clock.nowUs() / USEC_PER_MSEC;
+}
+
+time_t networkTimeManager::getCurrentTimeSec() const
+{
+    return clock.nowUs() / USEC_PER_SEC;
+}
+
+int64_t networkTimeManager::getCurrentTimeNs() const
+{
+    return clock.nowUs() * NSEC_PER_USEC;
+}
+
+struct timespec networkTimeManager::getCurrentTime() const
+{
+    int64_t         now = clock.nowUs();
+    struct timespec ts  = {};
+
+    ts.tv_sec  = now / USEC_PER_SEC;
+    ts.tv_nsec = (now % USEC_PER_SEC) * NSEC_PER_USEC;
+    return ts;
 }
 
 void networkTimeManager::convert_unix_time_to_date(uint64_t unix_time)
@@ -236,3 +647,41 @@ void networkTimeManager::convert_unix_time_to_date(uint64_t unix_time)
     MYLOG("UTC Time: %04d-%02d-%02d %02d:%02d:%02d", time_info.tm_year + 1900, time_info.tm_mon + 1, time_info.tm_mday,
           time_info.tm_hour, time_info.tm_min, time_info.tm_sec);
 }
+
+#if defined(CONFIG_SHELL)
+static int cmdTimeStatus(const struct shell* sh, size_t argc, char** argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    networkTimeManager&    ntp = networkTimeManager::getInstance();
+    clockDiscipline::stats s   = ntp.getClockStats();
+
+    if (!s.synced)
+    {
+        shell_print(sh, "Not synced");
+    }
+    else
+    {
+        shell_print(sh, "Epoch %lld us", (long long)ntp.getCurrentTimeUs());
+        shell_print(sh, "Last offset %lld us, frequency %d ppb", (long long)s.offset_us, s.freq_ppb);
+        shell_print(sh, "Sync interval %u s, %u steps, %u slews", s.interval_s, s.steps, s.slews);
+    }
+
+    networkTimeManager::serverStats servers[networkTimeManager::MAX_SERVERS];
+    size_t                          count = ntp.getServerStats(servers, ARRAY_SIZE(servers));
+    for (size_t i = 0; i < count; i++)
+    {
+        shell_print(sh, "%-20s reach %03o, RTT %u us, %u/%u answered, %u falsetickers, %u selected", servers[i].host,
+                    servers[i].reach, servers[i].rtt_us, servers[i].answered, servers[i].sent,
+                    servers[i].falsetickers, servers[i].selected);
+    }
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_time,
+                               SHELL_CMD(status, NULL, "Clock offset, frequency estimate, sync interval and servers",
+                                         cmdTimeStatus),
+                               SHELL_SUBCMD_SET_END);
+SHELL_CMD_REGISTER(time, &sub_time, "Network time", NULL);
+#endif
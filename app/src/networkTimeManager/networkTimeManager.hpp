@@ -20,19 +20,42 @@
 #pragma once
 
 #include "iManager.hpp"
+#include "clockDiscipline.hpp"
 #include <zephyr/kernel.h>
 #include <zephyr/sys/atomic.h>
-#include <zephyr/net/sntp.h>
 #include <zephyr/net/net_config.h>
+#include <zephyr/net/net_ip.h>
+#include <zephyr/zbus/zbus.h>
+#include <array>
 #include <vector>
 #include <string>
 
+/**
+ * @brief Outcome of one SNTP sync, published on time_sync_chan when it completes.
+ */
+struct timeSyncResult
+{
+    int      error;     /**< 0 on success, otherwise the negative errno of the last attempt */
+    uint8_t  attempts;  /**< Request rounds sent for this sync */
+    uint8_t  answered;  /**< Servers that answered */
+    uint8_t  rejected;  /**< Answers rejected as outliers */
+    uint32_t rtt_ms;    /**< Round trip of the selected server, 0 on failure */
+    int64_t  offset_us; /**< Server time minus the clock model before the correction, 0 on failure */
+    int64_t  uptime_ms; /**< Uptime at completion */
+};
+
+ZBUS_CHAN_DECLARE(time_sync_chan);
+
 /**
  * @class networkTimeManager
  * @brief Singleton class to manage network time synchronization and distribution.
  *
  * This class handles:
- * - SNTP time synchronization with network time servers
+ * - SNTP time synchronization with network time servers, without blocking any thread
+ * - Querying every configured server at once, rejecting outliers and preferring the best server
+ * - A disciplined clock (clockDiscipline) that slews small offsets, tracks the oscillator
+ *   frequency error and sets the sync interval
+ * - Syncing on its own schedule while the WAN is reachable (network_state_chan)
  * - Distribution of synchronized time to observers
  * - Thread-safe singleton pattern implementation
  * - Error handling and retry mechanisms
@@ -40,6 +63,25 @@
 class networkTimeManager : public iManager
 {
   public:
+    /**
+     * @brief Most servers taken from CONFIG_APP_SNTP_SERVERS.
+     */
+    static constexpr size_t MAX_SERVERS = 4;
+
+    /**
+     * @brief Track record of one SNTP server.
+     */
+    struct serverStats
+    {
+        const char* host;         /**< Name from CONFIG_APP_SNTP_SERVERS */
+        uint8_t     reach;        /**< One bit per recent request, set when it got a usable answer */
+        uint32_t    rtt_us;       /**< Smoothed round trip */
+        uint32_t    sent;         /**< Requests sent */
+        uint32_t    answered;     /**< Valid replies */
+        uint32_t    falsetickers; /**< Replies rejected as outliers */
+        uint32_t    selected;     /**< Syncs that used this server */
+    };
+
     /**
      * @brief Get the singleton instance of the networkTimeManager class.
      * @return Reference to the singleton instance.
@@ -53,7 +95,7 @@ class networkTimeManager : public iManager
     bool init() override;
 
     /**
-     * @brief Perform periodic time synchronization and updates.
+     * @brief Start a time synchronization, see startSync().
      */
     void tick() override;
 
@@ -112,12 +154,39 @@ class networkTimeManager : public iManager
     int getLastSyncError() const;
 
     /**
-     * @brief Synchronize time with SNTP server.
-     * @param server SNTP server address.
-     * @param timeout_ms Timeout in milliseconds.
-     * @return true if sync was successful, false otherwise.
+     * @brief Map a capture of the local time base to epoch time.
+     * @note Valid for captures taken before or after the call, so a sample stamped at the read keeps its time
+     *       however long it is queued.
+     * @param cycles Value from clockDiscipline::captureCycles().
+     * @return Epoch microseconds, 0 when not synced.
      */
-    bool sync(const char* server, int timeout_ms);
+    int64_t toEpochUs(uint64_t cycles) const;
+
+    /**
+     * @brief State of the clock model: offset, frequency estimate and sync interval.
+     */
+    clockDiscipline::stats getClockStats() const;
+
+    /**
+     * @brief Copy the track record of every configured server.
+     * @param out Filled with up to max entries.
+     * @return Number of entries written.
+     */
+    size_t getServerStats(serverStats* out, size_t max);
+
+    /**
+     * @brief Start an asynchronous sync with the SNTP servers, unless one is in flight.
+     * @note Returns at once. The requests go out from the system workqueue, the replies are handled on the
+     *       socketManager network thread and the result is published on time_sync_chan.
+     * @return true if a sync was started, false if one is already running.
+     */
+    bool startSync();
+
+    /**
+     * @brief zbus listener on network_state_chan, runs inside networkManager::tick().
+     * @note Public only for ZBUS_LISTENER_DEFINE.
+     */
+    static void network_state_listener(const struct zbus_channel* chan);
 
     bool is_synced() const;
 
@@ -139,16 +208,37 @@ class networkTimeManager : public iManager
     atomic_t                   last_sync_error;      /**< Last sync error code */
     atomic_t                   is_syncing;           /**< Flag indicating sync in progress */
     atomic_t                   is_sync_active;       /**< Flag indicating sync is active */
-    atomic_t                   synced;               /**< Flag indicating if time is synced */
-    atomic_t                   synced_time;          /**< Last synced time in milliseconds */
-    atomic_t                   last_uptime;          /**< Last uptime when time was synced */
+    atomic_t                   utc_offset_ms;        /**< Local time zone offset, with DST, set at each sync */
+    atomic_t                   wan_up;               /**< WAN reachable, from network_state_chan */
+    atomic_t                   sync_requested;       /**< WAN came up: sync without waiting for the interval */
     bool                       m_initialized{false}; /**< Initialization state flag */
-
-    /**
-     * @brief Time between sync attempts in milliseconds.
-     * @note This is set to 1 hour (3600000ms)
-     */
-    const uint32_t SYNC_INTERVAL;
+    clockDiscipline            clock;                /**< Epoch time model fed by the syncs */
+    struct k_work_delayable    sync_work;            /**< Next sync, then the timeout or retry delay of a request */
+    int64_t                    next_sync_at{0};      /**< Uptime of the next scheduled sync */
+    int                        sock{-1};             /**< UDP socket of the sync in flight, shared by all servers */
+    uint8_t                    attempt{0};           /**< Request rounds sent for the sync in flight */
+    bool                       awaiting{false};      /**< Requests are out and their timeout is armed */
+
+    /**
+     * @brief A configured server, its request in flight, its sample for this sync and its track record.
+     */
+    struct server
+    {
+        std::string     host;        /**< Name from CONFIG_APP_SNTP_SERVERS */
+        struct sockaddr addr;        /**< Address the request went to, replies must come from it */
+        uint32_t        cookie;      /**< Transmit timestamp fraction the reply must echo */
+        int64_t         sent_us;     /**< Local time the request was sent (T1) */
+        bool            pending;     /**< Request out, no reply yet */
+        bool            answered;    /**< The sample below is valid for this sync */
+        int64_t         server_us;   /**< Server epoch time at local_us, from the four timestamps */
+        int64_t         local_us;    /**< Local time the reply arrived */
+        uint32_t        rtt_us;      /**< Path delay of this request, without the server's processing time */
+        uint32_t        distance_us; /**< Error bound: half the RTT plus the server's root distance */
+        serverStats     stats;       /**< Track record across syncs */
+    };
+
+    std::array<server, MAX_SERVERS> servers;         /**< Parsed from CONFIG_APP_SNTP_SERVERS */
+    size_t                          server_count{0}; /**< Entries of servers in use */
 
     /**
      * @brief Maximum number of sync retries.
@@ -163,16 +253,15 @@ class networkTimeManager : public iManager
     static constexpr int RETRY_DELAY = 1000;
 
     /**
-     * @brief Timeout for sync operations in milliseconds.
+     * @brief Reply timeout of one SNTP request in milliseconds.
      * @note This is set to 5 seconds (5000ms)
      */
     const uint32_t SYNC_TIMEOUT = 5000;
 
     /**
-     * @brief SNTP server address.
-     * @note This is set to "pool.ntp.org"
+     * @brief Gain of the smoothed RTT, as a shift: each sample moves it by 1/8.
      */
-    const std::string SNTP_SERVER;
+    static constexpr uint8_t RTT_GAIN_SHIFT = 3;
 
     /**
      * @brief SNTP port.
@@ -211,12 +300,62 @@ class networkTimeManager : public iManager
     void reset_state();
 
     /**
-     * @brief Perform time synchronization with SNTP server.
-     * @param server SNTP server address.
-     * @param timeout_ms Timeout in milliseconds.
-     * @return true if sync was successful, false otherwise.
+     * @brief Work handler: starts a scheduled sync, sends the next request, or handles the timeout of the one in
+     *        flight.
      */
-    bool perform_sync(const char* server, int timeout_ms);
+    static void sync_work_handler(struct k_work* work);
+
+    /**
+     * @brief Open the socket if needed and send one SNTP request to every server that has not answered yet.
+     * @note Called with state_mutex held. A server whose address is not resolved yet is skipped this round.
+     * @return 0 if at least one request went out, negative errno otherwise.
+     */
+    int send_requests();
+
+    /**
+     * @brief Pick the sample to apply with sntpSelection and record the falsetickers it found.
+     * @note Called with state_mutex held. Marks the falsetickers in the server stats.
+     * @param rejected Set to the number of samples rejected as outliers.
+     * @return Index of the selected server.
+     */
+    size_t select_server(uint8_t& rejected);
+
+    /**
+     * @brief Apply the selected sample and finish the sync.
+     * @note Called with state_mutex held, with at least one answer.
+     */
+    void complete();
+
+    /**
+     * @brief Schedule the next attempt after a failure, or finish the sync once MAX_RETRIES are used up.
+     * @note Called with state_mutex held.
+     * @param error Negative errno of the failed attempt.
+     */
+    void retry_or_fail(int error);
+
+    /**
+     * @brief End the sync in flight: close the socket, publish the result and schedule the next sync.
+     * @note Called with state_mutex held.
+     */
+    void finish(int error, uint32_t rtt_ms, int64_t offset_us, uint8_t rejected);
+
+    /**
+     * @brief Called on the socketManager network thread when the SNTP socket is readable.
+     */
+    static void on_readable(int fd, void* ctx);
+
+    /**
+     * @brief Read and check a reply, record it as its server's sample and complete once all have answered.
+     */
+    void handle_reply();
+
+    /**
+     * @brief Feed a server time to the clock model.
+     * @param server_us Server epoch time in microseconds at local_us.
+     * @param local_us Local time (clockDiscipline::localUs()) at which it was received.
+     * @return Offset of the server from the model before the correction.
+     */
+    int64_t apply_time(int64_t server_us, int64_t local_us);
 
     /**
      * @brief Notify all observers of time updates.
@@ -236,13 +375,6 @@ class networkTimeManager : public iManager
      */
     bool validateServerConfig() const;
 
-    /**
-     * @brief Handle time synchronization errors.
-     * @param operation Operation that failed.
-     * @param error_code Error code.
-     */
-    void handle_error(const char* operation, int error_code);
-
     /**
      * @brief Check if it's time to perform a sync.
      * @return true if sync should be performed, false otherwise.
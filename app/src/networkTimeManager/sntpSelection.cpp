@@ -0,0 +1,85 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2025 Osama Salah-ud-Din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "sntpSelection.hpp"
+
+#include <algorithm>
+
+size_t sntpSelection::select(sample* samples, size_t count)
+{
+    /* The true time lies in each correct server's interval offset ± distance: find the point most of them share */
+    int64_t point = 0;
+    size_t  best  = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        int64_t low   = samples[i].offset_us - samples[i].distance_us;
+        size_t  votes = 0;
+
+        samples[i].falseticker = false;
+
+        for (size_t j = 0; j < count; j++)
+        {
+            const sample& b = samples[j];
+            votes += ((b.offset_us - b.distance_us) <= low) && (low <= (b.offset_us + b.distance_us)) ? 1 : 0;
+        }
+
+        if (votes > best)
+        {
+            best  = votes;
+            point = low;
+        }
+    }
+
+    /* Without a majority no side can be called wrong: take the median offset, the most central server */
+    if ((best * 2) <= count)
+    {
+        size_t order[MAX_SAMPLES];
+        for (size_t i = 0; i < count; i++)
+        {
+            order[i] = i;
+        }
+
+        std::sort(order, order + count,
+                  [samples](size_t a, size_t b) { return samples[a].offset_us < samples[b].offset_us; });
+        return order[(count - 1) / 2];
+    }
+
+    /* Among the truechimers prefer the most reachable server, then the fastest */
+    size_t selected = 0;
+    int    score    = -1;
+    for (size_t i = 0; i < count; i++)
+    {
+        sample& s = samples[i];
+
+        s.falseticker = ((s.offset_us - s.distance_us) > point) || (point > (s.offset_us + s.distance_us));
+        if (s.falseticker)
+        {
+            continue;
+        }
+
+        int reach = __builtin_popcount(s.reach);
+        if ((reach > score) || ((reach == score) && (s.rtt_us < samples[selected].rtt_us)))
+        {
+            score    = reach;
+            selected = i;
+        }
+    }
+
+    return selected;
+}
@@ -0,0 +1,62 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2025 Osama Salah-ud-Din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class sntpSelection
+ * @brief Picks the answer to apply out of one sync round, without any I/O.
+ *
+ * Every answer is an interval, offset ± distance, that holds the true offset if the
+ * server is correct. The point shared by the most intervals is found (Marzullo's
+ * algorithm); with a majority behind it, the answers that miss it are falsetickers and
+ * the most reachable, then fastest, of the rest is used. Without a majority the median
+ * offset is used and nothing is rejected.
+ */
+class sntpSelection
+{
+  public:
+    /**
+     * @brief Most samples select() takes.
+     */
+    static constexpr size_t MAX_SAMPLES = 8;
+
+    /**
+     * @brief One server's answer and track record.
+     */
+    struct sample
+    {
+        int64_t  offset_us;   /**< Server time minus local time */
+        uint32_t distance_us; /**< Error bound of the offset */
+        uint8_t  reach;       /**< Reachability register of the server */
+        uint32_t rtt_us;      /**< Smoothed round trip of the server */
+        bool     falseticker; /**< Set by select() when the interval misses the majority */
+    };
+
+    /**
+     * @brief Select the sample to apply and mark the falsetickers.
+     * @param samples Answers of this round, at least one.
+     * @param count Number of samples, at most MAX_SAMPLES.
+     * @return Index of the selected sample.
+     */
+    static size_t select(sample* samples, size_t count);
+};
@@ -24,16 +24,29 @@
 #include <zephyr/net/net_if.h>
 #include <zephyr/net/net_ip.h>
 #include <zephyr/net/icmp.h>
+#include <zephyr/net/net_pkt.h>
+#include <zephyr/random/random.h>
 #include <zephyr/kernel.h>
 
+/* Echo request/reply header following the ICMP header */
+struct icmpEcho
+{
+    uint16_t identifier;
+    uint16_t sequence;
+} __packed;
+
 /* Initialize static members */
 struct k_mutex pingManager::instance_mutex;
 pingManager*   pingManager::instance_ptr = nullptr;
 
-pingManager::pingManager()
+pingManager::pingManager() : requests{}
 {
-    k_mutex_init(&request_mutex);
     is_initialized = false;
+
+    for (pingRequest& req : requests)
+    {
+        k_work_init_delayable(&req.timeout_work, handle_timeout);
+    }
 }
 
 pingManager::~pingManager()
@@ -62,53 +75,58 @@ bool pingManager::init()
         return true;
     }
 
-    k_mutex_lock(&request_mutex, K_FOREVER);
-
     /* Initialize ICMP context */
     int ret = net_icmp_init_ctx(&icmp_ctx, NET_ICMPV4_ECHO_REPLY, 0, handle_reply);
     if (ret < 0)
     {
         MYLOG("❌ PingManager initialization failed: %d", ret);
-        k_mutex_unlock(&request_mutex);
         return false;
     }
 
+    /* Tell our replies apart from those of other ping users (net shell) */
+    identifier    = (uint16_t) sys_rand32_get();
+    next_sequence = 0;
+
     is_initialized = true;
     MYLOG("✅ PingManager initialized");
-    k_mutex_unlock(&request_mutex);
     return true;
 }
 
 void pingManager::tick()
 {
-    if (!is_initialized)
+    /* Timeouts fire from their own work items */
+}
+
+void pingManager::handle_timeout(struct k_work* work)
+{
+    struct k_work_delayable* dwork   = k_work_delayable_from_work(work);
+    pingRequest&             req     = *CONTAINER_OF(dwork, pingRequest, timeout_work);
+    pingManager&             manager = getInstance();
+
+    k_spinlock_key_t key = k_spin_lock(&manager.request_lock);
+
+    /* The slot may have been answered and reused since the work was queued */
+    if (!req.in_use || (k_uptime_get() - req.start_time < manager.PING_TIMEOUT_MS))
     {
+        k_spin_unlock(&manager.request_lock, key);
         return;
     }
 
-    k_mutex_lock(&request_mutex, K_FOREVER);
+    uint16_t        sequence = req.sequence;
+    struct sockaddr addr     = req.addr;
+    replyHandler    handler  = req.handler;
+    void*           ctx      = req.ctx;
 
-    int64_t current_time = k_uptime_get();
-    auto    it           = pending_requests.begin();
+    req.in_use = false;
+    k_spin_unlock(&manager.request_lock, key);
 
-    while (it != pending_requests.end())
+    char ip[NET_IPV6_ADDR_LEN];
+    MYLOG("❌ Ping to %s timed out (seq %u)", addr_to_str(addr, ip, sizeof(ip)), sequence);
+
+    if (handler)
     {
-        if (current_time - it->start_time > PING_TIMEOUT_MS)
-        {
-            MYLOG("❌ Ping to %s timed out", it->ip.c_str());
-            if (it->callback)
-            {
-                it->callback(false);
-            }
-            it = pending_requests.erase(it);
-        }
-        else
-        {
-            ++it;
-        }
+        handler(false, 0, ctx);
     }
-
-    k_mutex_unlock(&request_mutex);
 }
 
 const char* pingManager::name() const
@@ -116,55 +134,88 @@ const char* pingManager::name() const
     return "pingManager";
 }
 
-bool pingManager::send_ping(const char* ip, struct net_if* iface, std::function<void(bool)> callback)
+bool pingManager::send_ping(const char* ip, struct net_if* iface, replyHandler handler, void* ctx)
 {
-    if (!is_initialized)
+    if (!validate_ip(ip))
     {
-        MYLOG("❌ Ping manager not initialized");
+        MYLOG("❌ Invalid IP address: %s", ip);
         return false;
     }
 
-    if (!validate_ip(ip))
+    struct sockaddr addr;
+    if (!net_ipaddr_parse(ip, strlen(ip), &addr))
     {
-        MYLOG("❌ Invalid IP address: %s", ip);
+        MYLOG("❌ Failed to parse IP address: %s", ip);
         return false;
     }
 
-    if (!validate_interface(iface))
+    return send_ping(addr, iface, handler, ctx);
+}
+
+bool pingManager::send_ping(const struct sockaddr& addr, struct net_if* iface, replyHandler handler, void* ctx)
+{
+    if (!is_initialized)
     {
-        MYLOG("❌ Invalid network interface");
+        MYLOG("❌ Ping manager not initialized");
         return false;
     }
 
-    struct sockaddr addr;
-    int             ret = net_ipaddr_parse(ip, strlen(ip), &addr);
-    if (ret < 0)
+    if (!validate_interface(iface))
     {
-        MYLOG("❌ Failed to parse IP address: %s", ip);
+        MYLOG("❌ Invalid network interface");
         return false;
     }
 
-    k_mutex_lock(&request_mutex, K_FOREVER);
+    /* Claim any free slot: replies are matched by sequence number, not by slot */
+    k_spinlock_key_t key  = k_spin_lock(&request_lock);
+    pingRequest*     slot = nullptr;
 
-    PingRequest request;
-    request.start_time = k_uptime_get();
-    request.ip         = ip;
-    request.callback   = callback;
+    for (pingRequest& candidate : requests)
+    {
+        if (!candidate.in_use)
+        {
+            slot = &candidate;
+            break;
+        }
+    }
 
-    pending_requests.push_back(request);
+    if (slot == nullptr)
+    {
+        k_spin_unlock(&request_lock, key);
+        MYLOG("❌ Too many pings outstanding");
+        return false;
+    }
 
-    ret = net_icmp_send_echo_request(&icmp_ctx, iface, &addr, nullptr, nullptr);
+    pingRequest& req      = *slot;
+    uint16_t     sequence = next_sequence++;
+
+    req.in_use       = true;
+    req.sequence     = sequence;
+    req.start_time   = k_uptime_get();
+    req.start_cycles = k_cycle_get_32();
+    req.addr         = addr;
+    req.handler      = handler;
+    req.ctx          = ctx;
+    k_work_reschedule(&req.timeout_work, K_MSEC(PING_TIMEOUT_MS));
+    k_spin_unlock(&request_lock, key);
+
+    struct net_icmp_ping_params params = {};
+    params.identifier                  = identifier;
+    params.sequence                    = sequence;
+    params.priority                    = -1; /* Default packet priority */
+
+    int ret = net_icmp_send_echo_request(&icmp_ctx, iface, const_cast<struct sockaddr*>(&addr), &params, nullptr);
     if (ret < 0)
     {
         MYLOG("❌ Failed to send ping request: %d", ret);
-        pending_requests.pop_back();
-        k_mutex_unlock(&request_mutex);
+
+        key        = k_spin_lock(&request_lock);
+        req.in_use = false;
+        k_work_cancel_delayable(&req.timeout_work);
+        k_spin_unlock(&request_lock, key);
         return false;
     }
 
-    /*  MYLOG("🏓 Ping sent to %s", ip); */
-
-    k_mutex_unlock(&request_mutex);
     return true;
 }
 
@@ -175,58 +226,105 @@ void pingManager::cleanup()
         return;
     }
 
-    k_mutex_lock(&request_mutex, K_FOREVER);
+    net_icmp_cleanup_ctx(&icmp_ctx);
+    is_initialized = false;
 
-    /* Notify all pending requests of failure */
-    for (auto& request : pending_requests)
+    for (pingRequest& req : requests)
     {
-        if (request.callback)
+        struct k_work_sync sync;
+        k_work_cancel_delayable_sync(&req.timeout_work, &sync);
+
+        k_spinlock_key_t key     = k_spin_lock(&request_lock);
+        bool             pending = req.in_use;
+        replyHandler     handler = req.handler;
+        void*            ctx     = req.ctx;
+        req.in_use               = false;
+        k_spin_unlock(&request_lock, key);
+
+        /* Notify all pending requests of failure */
+        if (pending && handler)
         {
-            request.callback(false);
+            handler(false, 0, ctx);
         }
     }
 
-    pending_requests.clear();
-    net_icmp_cleanup_ctx(&icmp_ctx);
-    is_initialized = false;
-
     MYLOG("Ping manager cleaned up");
-    k_mutex_unlock(&request_mutex);
 }
 
 int pingManager::handle_reply(struct net_icmp_ctx* ctx, struct net_pkt* pkt, struct net_icmp_ip_hdr* ip_hdr,
                               struct net_icmp_hdr* icmp_hdr, void* user_data)
 {
-    char addr_str[NET_IPV4_ADDR_LEN];
-    net_addr_ntop(AF_INET, &ip_hdr->ipv4->src, addr_str, sizeof(addr_str));
+    NET_PKT_DATA_ACCESS_CONTIGUOUS_DEFINE(echo_access, struct icmpEcho);
+
+    /* Runs in the RX thread: no formatting, no logging, no blocking lock */
+    net_pkt_cursor_init(pkt);
+    if (net_pkt_skip(pkt, net_pkt_ip_hdr_len(pkt) + net_pkt_ipv4_opts_len(pkt) + sizeof(struct net_icmp_hdr)) < 0)
+    {
+        return -EIO;
+    }
+
+    const struct icmpEcho* echo = (const struct icmpEcho*) net_pkt_get_data(pkt, &echo_access);
+    if (echo == nullptr)
+    {
+        return -EIO;
+    }
 
-    pingManager& manager = getInstance();
+    pingManager& manager  = getInstance();
+    uint16_t     sequence = ntohs(echo->sequence);
 
-    k_mutex_lock(&manager.request_mutex, K_FOREVER);
+    if (ntohs(echo->identifier) != manager.identifier)
+    {
+        return 0;
+    }
 
-    auto it = std::find_if(manager.pending_requests.begin(), manager.pending_requests.end(),
-                           [&](const PingRequest& req) { return req.ip == addr_str; });
+    k_spinlock_key_t key     = k_spin_lock(&manager.request_lock);
+    pingRequest*     req     = manager.find_request(sequence);
+    bool             matched = (req != nullptr);
+    replyHandler     handler = nullptr;
+    void*            arg     = nullptr;
+    uint32_t         rtt     = 0;
 
-    if (it != manager.pending_requests.end())
+    if (matched)
     {
-        int64_t end_time = k_uptime_get() - it->start_time;
-        MYLOG("✅ Received ping reply from %s %lldms", addr_str, end_time);
+        handler = req->handler;
+        arg     = req->ctx;
+        rtt     = k_cyc_to_us_floor32(k_cycle_get_32() - req->start_cycles);
 
-        if (it->callback)
-        {
-            it->callback(true);
-        }
-        manager.pending_requests.erase(it);
+        /* Under the lock: once released, the slot may carry a new request and its timeout */
+        req->in_use = false;
+        k_work_cancel_delayable(&req->timeout_work);
     }
-    else
+    k_spin_unlock(&manager.request_lock, key);
+
+    /* Late replies to a request that already timed out are dropped */
+    if (matched && handler)
     {
-        MYLOG("Received unexpected ping reply from %s", addr_str);
+        handler(true, rtt, arg);
     }
-
-    k_mutex_unlock(&manager.request_mutex);
     return 0;
 }
 
+pingManager::pingRequest* pingManager::find_request(uint16_t sequence)
+{
+    for (pingRequest& req : requests)
+    {
+        if (req.in_use && (req.sequence == sequence))
+        {
+            return &req;
+        }
+    }
+    return nullptr;
+}
+
+const char* pingManager::addr_to_str(const struct sockaddr& addr, char* buf, size_t len)
+{
+    const void* raw = (addr.sa_family == AF_INET6) ? (const void*) &net_sin6(&addr)->sin6_addr
+                                                   : (const void*) &net_sin(&addr)->sin_addr;
+    const char* str = net_addr_ntop(addr.sa_family, raw, buf, len);
+
+    return str ? str : "?";
+}
+
 bool pingManager::validate_interface(struct net_if* iface)
 {
     if (iface == nullptr)
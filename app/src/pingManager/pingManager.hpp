@@ -26,21 +26,26 @@
 #include <zephyr/net/net_ip.h>
 #include <zephyr/kernel.h>
 
-#include <vector>
-#include <string>
-#include <functional>
 #include <atomic>
 
 class pingManager : public iManager
 {
   public:
     /***** Local Type Definition *******/
-    struct PingRequest
-    {
-        int64_t                   start_time;
-        std::string               ip;
-        std::function<void(bool)> callback;
-    };
+    /**
+     * @brief Result of a ping.
+     * @note Called from the network RX thread for a reply and from the system workqueue
+     *       for a timeout; it must not block.
+     * @param reachable true if the echo reply arrived in time.
+     * @param rtt_us Round-trip time, 0 on timeout.
+     * @param ctx User context given to send_ping().
+     */
+    using replyHandler = void (*)(bool reachable, uint32_t rtt_us, void* ctx);
+
+    /**
+     * @brief Maximum number of outstanding pings
+     */
+    static constexpr size_t MAX_PENDING = 8;
 
     /***** Constructors *******/
     /**
@@ -73,7 +78,7 @@ class pingManager : public iManager
 
     /**
      * @brief Periodic Tick function of the pingManager class.
-     * @note This function should be called periodically to handle ping requests.
+     * @note Nothing to do: every request times out on its own delayable work item.
      */
     void tick() override;
 
@@ -89,10 +94,22 @@ class pingManager : public iManager
      * @brief Send ping on the specified IP address.
      * @param const char* ip - string ip address.
      * @param struct net_if *iface - network interface to use.
-     * @param std::function<void(bool)> callback - callback function to handle the result.
+     * @param handler Called with the result, may be nullptr.
+     * @param ctx User context passed back to @p handler.
      * @return true if ping request was sent successfully, false otherwise.
      */
-    bool send_ping(const char* ip, struct net_if* iface = nullptr, std::function<void(bool)> callback = nullptr);
+    bool send_ping(const char* ip, struct net_if* iface = nullptr, replyHandler handler = nullptr,
+                   void* ctx = nullptr);
+
+    /**
+     * @brief Send ping to an already resolved address.
+     * @note Each request gets its own ICMP sequence number, so several pings to the
+     *       same host are matched to their own replies.
+     * @return true if ping request was sent successfully, false otherwise (also when
+     *         MAX_PENDING requests are outstanding).
+     */
+    bool send_ping(const struct sockaddr& addr, struct net_if* iface = nullptr, replyHandler handler = nullptr,
+                   void* ctx = nullptr);
 
     /**
      * @brief Cleanup the pingManager class.
@@ -101,21 +118,53 @@ class pingManager : public iManager
     void cleanup();
 
   private:
+    /**** Private Types ******/
+    /**
+     * @brief Outstanding echo request, in any free slot of the table.
+     */
+    struct pingRequest
+    {
+        bool            in_use;
+        uint16_t        sequence;
+        int64_t         start_time;
+        uint32_t        start_cycles;
+        struct sockaddr addr;
+        replyHandler    handler;
+        void*           ctx;
+
+        /* Fires the timeout at start_time + PING_TIMEOUT_MS, cancelled by the reply */
+        struct k_work_delayable timeout_work;
+    };
+
     /**** Private Members ******/
     static struct k_mutex instance_mutex;
     static pingManager*   instance_ptr;
-    struct k_mutex        request_mutex;
     std::atomic<bool>     is_initialized{false};
 
+    /**
+     * @brief Guards the request table; short enough for the RX thread.
+     */
+    struct k_spinlock request_lock;
+
     /**
      * Define a timeout threshold (e.g., 5000ms or 5 seconds) for ping requests.
      */
     const uint16_t PING_TIMEOUT_MS = 5000;
 
     /**
-     * Vector to store pending ping requests.
+     * Table of pending ping requests; replies are looked up by sequence number.
+     */
+    pingRequest requests[MAX_PENDING];
+
+    /**
+     * ICMP identifier of this manager's echo requests, replies with another one are ignored.
      */
-    std::vector<PingRequest> pending_requests;
+    uint16_t identifier = 0;
+
+    /**
+     * Sequence number of the next echo request.
+     */
+    uint16_t next_sequence = 0;
 
     /**
      * ICMP context for ping operations.
@@ -134,6 +183,24 @@ class pingManager : public iManager
     static int handle_reply(struct net_icmp_ctx* ctx, struct net_pkt* pkt, struct net_icmp_ip_hdr* ip_hdr,
                             struct net_icmp_hdr* icmp_hdr, void* user_data);
 
+    /**
+     * @brief Find the outstanding request with @p sequence.
+     * @note Called with request_lock held.
+     * @return The request, or nullptr if it was answered, timed out or never sent.
+     */
+    pingRequest* find_request(uint16_t sequence);
+
+    /**
+     * @brief Time out one request.
+     * @note Runs on the system workqueue when the request's deadline passes.
+     */
+    static void handle_timeout(struct k_work* work);
+
+    /**
+     * @brief Log an address for a timeout or an error.
+     */
+    static const char* addr_to_str(const struct sockaddr& addr, char* buf, size_t len);
+
     /**
      * @brief Validate the network interface.
      * @param iface Network interface to validate.
@@ -0,0 +1,145 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2025 Osama Salah-ud-Din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "reconnectPolicy.hpp"
+#include "myLogger.hpp"
+
+#include <zephyr/random/random.h>
+#include <zephyr/sys/util.h>
+
+reconnectPolicy& reconnectPolicy::getInstance()
+{
+#if defined(CONFIG_APP_RECONNECT_POLICY_FIXED)
+    static fixedReconnectPolicy instance;
+#elif defined(CONFIG_APP_RECONNECT_POLICY_CIRCUIT_BREAKER)
+    static circuitBreakerReconnectPolicy instance;
+#else
+    static backoffReconnectPolicy instance;
+#endif
+    return instance;
+}
+
+uint32_t reconnectPolicy::connectTimeout() const
+{
+    return CONFIG_APP_WIFI_CONNECT_TIMEOUT * 1000U;
+}
+
+void reconnectPolicy::onSuccess(uint32_t duration_ms)
+{
+    recordAttempt(duration_ms);
+    counters.successes++;
+    counters.consecutive_failures = 0;
+}
+
+void reconnectPolicy::onFailure(uint32_t duration_ms)
+{
+    recordAttempt(duration_ms);
+    counters.failures++;
+    counters.consecutive_failures++;
+}
+
+reconnectPolicy::stats reconnectPolicy::getStats() const
+{
+    return counters;
+}
+
+uint32_t reconnectPolicy::equalJitter(uint32_t delay_ms)
+{
+    return (delay_ms / 2) + (sys_rand32_get() % ((delay_ms / 2) + 1));
+}
+
+uint32_t reconnectPolicy::recordWait(uint32_t delay_ms)
+{
+    counters.wait_ms_sum += delay_ms;
+    return delay_ms;
+}
+
+void reconnectPolicy::recordAttempt(uint32_t duration_ms)
+{
+    counters.attempts++;
+    counters.attempt_ms_sum += duration_ms;
+    counters.attempt_ms_max = MAX(counters.attempt_ms_max, duration_ms);
+}
+
+const char* fixedReconnectPolicy::name() const
+{
+    return "fixed";
+}
+
+uint32_t fixedReconnectPolicy::nextDelay()
+{
+    return recordWait(DELAY_MS);
+}
+
+const char* backoffReconnectPolicy::name() const
+{
+    return "backoff";
+}
+
+uint32_t backoffReconnectPolicy::nextDelay()
+{
+    return recordWait(backoff(counters.consecutive_failures));
+}
+
+uint32_t backoffReconnectPolicy::backoff(uint32_t failures) const
+{
+    uint32_t shift = MIN(failures, 16U);
+    uint32_t delay = MIN(BASE_MS << shift, CONFIG_APP_RECONNECT_MAX_DELAY * 1000U);
+    return equalJitter(delay);
+}
+
+#if defined(CONFIG_APP_RECONNECT_POLICY_CIRCUIT_BREAKER)
+const char* circuitBreakerReconnectPolicy::name() const
+{
+    return "circuit-breaker";
+}
+
+uint32_t circuitBreakerReconnectPolicy::nextDelay()
+{
+    if (!open)
+    {
+        return backoffReconnectPolicy::nextDelay();
+    }
+
+    /* Half-open: one probe per cooldown, jittered like the backoff */
+    return recordWait(equalJitter(CONFIG_APP_RECONNECT_BREAKER_COOLDOWN * 1000U));
+}
+
+void circuitBreakerReconnectPolicy::onSuccess(uint32_t duration_ms)
+{
+    reconnectPolicy::onSuccess(duration_ms);
+    if (open)
+    {
+        MYLOG("🔌 Reconnect circuit closed");
+        open = false;
+    }
+}
+
+void circuitBreakerReconnectPolicy::onFailure(uint32_t duration_ms)
+{
+    reconnectPolicy::onFailure(duration_ms);
+    if (!open && (counters.consecutive_failures >= CONFIG_APP_RECONNECT_BREAKER_THRESHOLD))
+    {
+        MYLOG("🔌 Reconnect circuit open after %u failures, probing every %u s", counters.consecutive_failures,
+              CONFIG_APP_RECONNECT_BREAKER_COOLDOWN);
+        open = true;
+        counters.trips++;
+    }
+}
+#endif
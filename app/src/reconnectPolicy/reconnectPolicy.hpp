@@ -0,0 +1,169 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2025 Osama Salah-ud-Din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <zephyr/kernel.h>
+
+/**
+ * @class reconnectPolicy
+ * @brief Decides when networkManager retries a lost or failed Wi-Fi connection.
+ *
+ * networkManager reports the outcome of every connect attempt and asks the
+ * policy how long to wait before the next one and how long an attempt may take.
+ * The policy in use is selected with the APP_RECONNECT_POLICY Kconfig choice.
+ */
+class reconnectPolicy
+{
+  public:
+    /**
+     * @brief Attempt counters and durations kept by every policy.
+     */
+    struct stats
+    {
+        uint32_t attempts;             /**< Attempts that ended in success or failure */
+        uint32_t successes;            /**< Attempts that reached Connected */
+        uint32_t failures;             /**< Attempts that failed or timed out */
+        uint32_t consecutive_failures; /**< Failures since the last success */
+        uint32_t trips;                /**< Times the circuit breaker opened */
+        uint32_t attempt_ms_sum;       /**< Time spent connecting, all attempts */
+        uint32_t attempt_ms_max;       /**< Longest attempt */
+        uint32_t wait_ms_sum;          /**< Delays handed out between attempts */
+    };
+
+    /**
+     * @brief Get the policy selected in Kconfig.
+     * @return Reference to the policy instance.
+     */
+    static reconnectPolicy& getInstance();
+
+    virtual ~reconnectPolicy() = default;
+
+    /**
+     * @brief Name of the policy, for logs.
+     */
+    virtual const char* name() const = 0;
+
+    /**
+     * @brief Delay before the next attempt.
+     * @note Called once per lost connection or failed attempt.
+     * @return Delay in ms.
+     */
+    virtual uint32_t nextDelay() = 0;
+
+    /**
+     * @brief Longest an attempt may stay in Connecting before it counts as failed.
+     * @return Timeout in ms.
+     */
+    virtual uint32_t connectTimeout() const;
+
+    /**
+     * @brief Report an attempt that reached Connected.
+     * @param duration_ms Time from the connect request to Connected.
+     */
+    virtual void onSuccess(uint32_t duration_ms);
+
+    /**
+     * @brief Report an attempt that failed or timed out.
+     * @param duration_ms Time from the connect request to the failure.
+     */
+    virtual void onFailure(uint32_t duration_ms);
+
+    /**
+     * @brief Get the counters of this policy.
+     */
+    stats getStats() const;
+
+    /**
+     * @brief Equal jitter: half of the delay fixed, the other half random, so devices do not retry in lockstep.
+     * @note Shared with the socket strategies' reconnect backoff.
+     * @return A delay in [delay_ms / 2, delay_ms].
+     */
+    static uint32_t equalJitter(uint32_t delay_ms);
+
+  protected:
+    stats counters = {};
+
+    /**
+     * @brief Record a delay handed out by nextDelay().
+     * @return The delay, for chaining.
+     */
+    uint32_t recordWait(uint32_t delay_ms);
+
+  private:
+    void recordAttempt(uint32_t duration_ms);
+};
+
+/**
+ * @brief Fixed delay between attempts, the original behaviour.
+ */
+class fixedReconnectPolicy : public reconnectPolicy
+{
+  public:
+    const char* name() const override;
+    uint32_t    nextDelay() override;
+
+  private:
+    /**
+     * @brief Delay between attempts
+     */
+    static constexpr uint32_t DELAY_MS = 10000;
+};
+
+/**
+ * @brief Exponential backoff with equal jitter, reset by a success.
+ * @note The jitter spreads devices that lost the same AP, so they do not retry in lockstep.
+ */
+class backoffReconnectPolicy : public reconnectPolicy
+{
+  public:
+    const char* name() const override;
+    uint32_t    nextDelay() override;
+
+  protected:
+    /**
+     * @brief Backoff delay for a number of consecutive failures, jittered.
+     */
+    uint32_t backoff(uint32_t failures) const;
+
+  private:
+    /**
+     * @brief First delay after a lost connection
+     */
+    static constexpr uint32_t BASE_MS = 2000;
+};
+
+/**
+ * @brief Backoff that stops retrying a dead AP at full rate.
+ *
+ * Closed: behaves like backoffReconnectPolicy. After CONFIG_APP_RECONNECT_BREAKER_THRESHOLD
+ * consecutive failures the breaker opens and only one probe is made per cooldown period
+ * (half-open). A successful probe closes it again.
+ */
+class circuitBreakerReconnectPolicy : public backoffReconnectPolicy
+{
+  public:
+    const char* name() const override;
+    uint32_t    nextDelay() override;
+    void        onSuccess(uint32_t duration_ms) override;
+    void        onFailure(uint32_t duration_ms) override;
+
+  private:
+    bool open = false;
+};
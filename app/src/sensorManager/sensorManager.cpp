@@ -27,8 +27,16 @@
 #include "socketManager.hpp"
 #include "sockets.hpp"
 #include "myLogger.hpp"
+#include "networkTimeManager.hpp"
+#include "clockDiscipline.hpp"
+#if defined(CONFIG_APP_COAP_SERVER)
+#include "coapServer.hpp"
+#endif
 
 #include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <cstdio>
+#include <cstring>
 
 /* Initialize static members */
 struct k_mutex sensorManager::instance_mutex;
@@ -74,15 +82,45 @@ void sensorManager::tick()
         return;
     }
 
+    networkTimeManager& ntp = networkTimeManager::getInstance();
+
     k_mutex_lock(&sensor_mutex, K_FOREVER);
 
     for (_sensor it : sensors)
     {
-        if (it._sensor && it._socket)
+        if (!it._sensor)
+        {
+            continue;
+        }
+
+        /* Stamped at the read: queueing, batching and Wi-Fi retries do not move the sample in time */
+        uint64_t cycles   = clockDiscipline::captureCycles();
+        float    value    = it._sensor->get_value();
+        int64_t  epoch_us = ntp.toEpochUs(cycles);
+
+#if defined(CONFIG_APP_COAP_SERVER)
+        /* Recorded for history; only sent if someone observes the sensor */
+        coapServer::getInstance().publish(it._sensor, value, epoch_us);
+#endif
+
+        if (it._socket)
         {
-            float       value   = it._sensor->get_value();
-            std::string payload = std::string(it._sensor->get_id()) + ":" + std::to_string(value);
-            it._socket->send(payload.c_str(), payload.length());
+            /* "id:value@epoch_us" sent from its parts, no temporary string */
+            char        text[16];
+            char        stamp[24];
+            const char* id        = it._sensor->get_id();
+            int         len       = snprintf(text, sizeof(text), "%f", (double)value);
+            int         stamp_len = snprintf(stamp, sizeof(stamp), "@%lld", (long long)epoch_us);
+
+            struct iovec record[] = {
+                {const_cast<char*>(id), strlen(id)},
+                {const_cast<char*>(":"), 1},
+                {text, (size_t)MIN(len, (int)sizeof(text) - 1)},
+                {stamp, (size_t)MIN(stamp_len, (int)sizeof(stamp) - 1)},
+            };
+
+            /* Before the first sync there is no epoch time: the receiver stamps on arrival */
+            it._socket->send(record, (epoch_us != 0) ? ARRAY_SIZE(record) : ARRAY_SIZE(record) - 1);
         }
     }
 
@@ -102,9 +140,9 @@ bool sensorManager::add_sensor(sensor* sensor, sockets* socket)
         return false;
     }
 
-    if (!sensor || !socket)
+    if (!sensor)
     {
-        MYLOG("❌ Invalid sensor or socket pointer");
+        MYLOG("❌ Invalid sensor pointer");
         return false;
     }
 
@@ -128,6 +166,22 @@ bool sensorManager::add_sensor(sensor* sensor, sockets* socket)
     return true;
 }
 
+size_t sensorManager::sensor_count()
+{
+    k_mutex_lock(&sensor_mutex, K_FOREVER);
+    size_t count = sensors.size();
+    k_mutex_unlock(&sensor_mutex);
+    return count;
+}
+
+sensor* sensorManager::get_sensor(size_t index)
+{
+    k_mutex_lock(&sensor_mutex, K_FOREVER);
+    sensor* result = (index < sensors.size()) ? sensors[index]._sensor : nullptr;
+    k_mutex_unlock(&sensor_mutex);
+    return result;
+}
+
 void sensorManager::cleanup()
 {
     if (!is_initialized)
@@ -60,10 +60,22 @@ class sensorManager : public iManager
     /**
      * @brief Add a sensor to the manager.
      * @param sensor Pointer to the sensor to add.
-     * @param socket Pointer to the socket for the sensor.
+     * @param socket Pointer to the socket readings are pushed to, nullptr for a pull-only sensor.
      * @return true if sensor was added successfully, false otherwise.
      */
-    bool add_sensor(sensor* sensor, sockets* socket);
+    bool add_sensor(sensor* sensor, sockets* socket = nullptr);
+
+    /**
+     * @brief Number of sensors added to the manager.
+     */
+    size_t sensor_count();
+
+    /**
+     * @brief Get a sensor by position.
+     * @param index Position in the order the sensors were added.
+     * @return The sensor, or nullptr if index is out of range.
+     */
+    sensor* get_sensor(size_t index);
 
     /**
      * @brief Cleanup the sensorManager class.
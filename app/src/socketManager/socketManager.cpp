@@ -21,9 +21,37 @@
 
 #include "socketManager.hpp"
 #include "socketStrategy.hpp"
+#if defined(CONFIG_APP_MQTT)
+#include "mqttSocketStrategy.hpp"
+#endif
 
 #include "myLogger.hpp"
 
+#include <zephyr/net/socket.h>
+#include <zephyr/posix/sys/eventfd.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+#include <zephyr/sys/util.h>
+#include <cstring>
+
+#define SOCKET_RX_STACK_SIZE (3072)
+#define SOCKET_RX_PRIORITY (K_PRIO_PREEMPT(7))
+
+K_THREAD_STACK_DEFINE(socket_rx_stack, SOCKET_RX_STACK_SIZE);
+
+/* RX buffer pool shared by all sockets, no heap on the receive path */
+K_MEM_SLAB_DEFINE_STATIC(socket_rx_slab, socketManager::RX_BUF_SIZE, socketManager::RX_BUF_COUNT, 4);
+
+/* TX buffer pool shared by all async sockets */
+K_MEM_SLAB_DEFINE_STATIC(socket_tx_slab, sizeof(socketManager::txItem), socketManager::TX_BUF_COUNT, 4);
+
+/* Scratch buffer to drain a socket when the pool is exhausted */
+static uint8_t rx_discard[socketManager::RX_BUF_SIZE];
+
+/* Indexed by socketManager::protocol */
+static const char* const protocol_names[] = {"TCP", "UDP", "TLS", "MQTT"};
+
 static socketManager* instance_ptr = nullptr;
 
 socketManager& socketManager::getInstance()
@@ -36,23 +64,56 @@ socketManager& socketManager::getInstance()
     return *instance_ptr;
 }
 
+socketManager::socketManager()
+{
+    k_mutex_init(&lock);
+    k_condvar_init(&unpinned);
+    atomic_set(&worker_started, 0);
+}
+
 bool socketManager::open(protocol proto, const std::string& host, uint16_t port)
 {
-    auto key = std::make_tuple(proto, host, port);
     bool ret = false;
 
-    if (sockets.find(key) != sockets.end())
+    k_mutex_lock(&lock, K_FOREVER);
+
+    socketEntry* existing = find(proto, host, port);
+    if (existing != nullptr)
     {
-        MYLOG("Socket already open for protocol %d port %d on Host %s",
-                (int)proto, port, host.c_str());
+        /* Attach to the open strategy instead of opening a second context */
+        existing->refs++;
+        k_mutex_unlock(&lock);
+        return true;
     }
     else
     {
-        auto strategy = createStrategy(proto, port);
+        socketEntry* slot = nullptr;
+        for (auto& entry : entries)
+        {
+            /* A slot still pinned is being released by close() */
+            if (!entry.in_use && (entry.pins == 0))
+            {
+                slot = &entry;
+                break;
+            }
+        }
+
+        auto strategy = slot ? createStrategy(proto, port) : nullptr;
         if (strategy && strategy->connect(host, port))
         {
-            /* Store it in the socket list */
-            sockets[key] = std::move(strategy);
+            /* Store it in the socket table */
+            slot->in_use   = true;
+            slot->refs     = 1;
+            slot->proto    = proto;
+            slot->host     = host;
+            slot->port     = port;
+            slot->strategy = std::move(strategy);
+            slot->handler  = nullptr;
+            slot->rx       = {};
+            slot->async    = false;
+            slot->tx       = {};
+            slot->traffic  = {};
+            k_msgq_init(&slot->tx_queue, (char*)slot->tx_queue_buf, sizeof(void*), TX_QUEUE_DEPTH);
 
             MYLOG("Opened %d socket on port %d", (int)proto, port);
             ret = true;
@@ -62,43 +123,735 @@ bool socketManager::open(protocol proto, const std::string& host, uint16_t port)
             MYLOG("Failed to open %d socket on port %d", (int)proto, port);
         }
     }
+
+    k_mutex_unlock(&lock);
+
+    if (ret)
+    {
+        startWorker();
+        wakeWorker();
+    }
     return ret;
 }
 
+void socketManager::close(protocol proto, const std::string& host, uint16_t port)
+{
+    std::unique_ptr<socketStrategy> strategy;
+
+    k_mutex_lock(&lock, K_FOREVER);
+
+    socketEntry* entry = find(proto, host, port);
+    if (entry == nullptr)
+    {
+        k_mutex_unlock(&lock);
+        return;
+    }
+
+    if (--entry->refs > 0)
+    {
+        k_mutex_unlock(&lock);
+        return;
+    }
+
+    release(*entry, strategy);
+    k_mutex_unlock(&lock);
+
+    /* Disconnect outside the lock: strategies may wait for their work items */
+    strategy->disconnect();
+    strategy.reset();
+
+    /* Drop the descriptor from the worker's poll set */
+    wakeWorker();
+    MYLOG("Closed %d socket on port %d", (int)proto, port);
+}
+
+void socketManager::unpin(socketEntry& entry)
+{
+    if (--entry.pins == 0)
+    {
+        k_condvar_broadcast(&unpinned);
+    }
+}
+
+void socketManager::release(socketEntry& entry, std::unique_ptr<socketStrategy>& strategy)
+{
+    txItem* item = nullptr;
+
+    /* find() no longer returns the entry, so no new pins are taken */
+    entry.in_use = false;
+
+    /* Wakes producers blocked on a full queue */
+    k_msgq_purge(&entry.tx_queue);
+
+    /* Wait for sends and producers still running unlocked on the entry */
+    while (entry.pins > 0)
+    {
+        k_condvar_wait(&unpinned, &lock, K_FOREVER);
+    }
+
+    while (k_msgq_get(&entry.tx_queue, &item, K_NO_WAIT) == 0)
+    {
+        k_mem_slab_free(&socket_tx_slab, item);
+    }
+
+    strategy          = std::move(entry.strategy);
+    entry.refs        = 0;
+    entry.async       = false;
+    entry.handler     = nullptr;
+    entry.handler_ctx = nullptr;
+    entry.host.clear();
+}
+
 ssize_t socketManager::send(std::string& host, protocol proto, uint16_t port ,const void* data, size_t len)
 {
-    int ret = -1;
+    struct iovec iov = {const_cast<void*>(data), len};
+    return send(host, proto, port, &iov, 1);
+}
+
+ssize_t socketManager::send(std::string& host, protocol proto, uint16_t port, const struct iovec* iov, size_t count)
+{
+    ssize_t ret = -1;
 
-    auto key = std::make_tuple(proto, host, port);
+    k_mutex_lock(&lock, K_FOREVER);
 
-    auto it = sockets.find(key);
-    if (it != sockets.end())
+    socketEntry* entry = find(proto, host, port);
+    if (entry && entry->async)
+    {
+        /* Only the queue is touched from here, never the strategy */
+        ret = enqueue(*entry, iov, count);
+    }
+    else if (entry)
     {
-        ret = it->second->send(data, len);
+        ret = sendTimed(*entry, iov, count);
     }
     else
     {
         MYLOG("No socket open for port %d",  port);
     }
 
+    k_mutex_unlock(&lock);
+    return ret;
+}
+
+bool socketManager::setAsync(const std::string& host, protocol proto, uint16_t port, overflowPolicy policy,
+                             uint32_t timeout_ms)
+{
+    bool ret = false;
+
+    k_mutex_lock(&lock, K_FOREVER);
+    socketEntry* entry = find(proto, host, port);
+    if (entry)
+    {
+        entry->policy        = policy;
+        entry->block_timeout = K_MSEC(timeout_ms);
+        entry->async         = true;
+        ret                  = true;
+    }
+    k_mutex_unlock(&lock);
+
+    return ret;
+}
+
+bool socketManager::getTxStats(const std::string& host, protocol proto, uint16_t port, txStats& stats)
+{
+    bool ret = false;
+
+    k_mutex_lock(&lock, K_FOREVER);
+    socketEntry* entry = find(proto, host, port);
+    if (entry)
+    {
+        stats = entry->tx;
+        ret   = true;
+    }
+    k_mutex_unlock(&lock);
+
+    return ret;
+}
+
+ssize_t socketManager::enqueue(socketEntry& entry, const struct iovec* iov, size_t count)
+{
+    size_t      len     = socketStrategy::totalLength(iov, count);
+    txItem*     item    = nullptr;
+    bool        block   = (entry.policy == overflowPolicy::BLOCK);
+    k_timeout_t timeout = entry.block_timeout;
+    int         rc;
+
+    /* Called locked. No logging here: myLogger itself sends through an async socket */
+    if (len > TX_BUF_SIZE)
+    {
+        entry.tx.dropped++;
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    rc = k_mem_slab_alloc(&socket_tx_slab, (void**)&item, K_NO_WAIT);
+    if ((rc != 0) && block)
+    {
+        /* Wait unlocked and pinned, the network thread needs the lock to free buffers */
+        entry.pins++;
+        k_mutex_unlock(&lock);
+        rc = k_mem_slab_alloc(&socket_tx_slab, (void**)&item, timeout);
+        k_mutex_lock(&lock, K_FOREVER);
+        unpin(entry);
+
+        if ((rc == 0) && !entry.in_use)
+        {
+            /* Closed while waiting */
+            k_mem_slab_free(&socket_tx_slab, item);
+            errno = ENOTCONN;
+            return -1;
+        }
+    }
+
+    if (rc != 0)
+    {
+        /* Pool exhausted: only drop-oldest may reclaim from its own queue */
+        if ((entry.policy != overflowPolicy::DROP_OLDEST) ||
+            (k_msgq_get(&entry.tx_queue, &item, K_NO_WAIT) != 0))
+        {
+            entry.tx.dropped++;
+            errno = ENOBUFS;
+            return -1;
+        }
+        entry.tx.dropped++;
+    }
+
+    /* The one copy of an async send: gather straight into the TX buffer */
+    item->len = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        memcpy(item->data + item->len, iov[i].iov_base, iov[i].iov_len);
+        item->len += iov[i].iov_len;
+    }
+
+    while (k_msgq_put(&entry.tx_queue, &item, K_NO_WAIT) != 0)
+    {
+        txItem* oldest = nullptr;
+
+        if ((entry.policy == overflowPolicy::DROP_OLDEST) && (k_msgq_get(&entry.tx_queue, &oldest, K_NO_WAIT) == 0))
+        {
+            k_mem_slab_free(&socket_tx_slab, oldest);
+            entry.tx.dropped++;
+            continue;
+        }
+
+        if (block)
+        {
+            /* close() purges the queue, which fails this wait */
+            entry.pins++;
+            k_mutex_unlock(&lock);
+            rc = k_msgq_put(&entry.tx_queue, &item, timeout);
+            k_mutex_lock(&lock, K_FOREVER);
+            unpin(entry);
+
+            if (rc == 0)
+            {
+                break;
+            }
+            block = false;
+            continue;
+        }
+
+        k_mem_slab_free(&socket_tx_slab, item);
+        entry.tx.dropped++;
+        errno = ENOBUFS;
+        return -1;
+    }
+
+    uint32_t depth = k_msgq_num_used_get(&entry.tx_queue);
+    entry.tx.queued++;
+    entry.tx.high_water = MAX(entry.tx.high_water, depth);
+
+    wakeWorker();
+    return len;
+}
+
+ssize_t socketManager::sendTimed(socketEntry& entry, const struct iovec* iov, size_t count)
+{
+    socketStrategy* strategy = entry.strategy.get();
+
+    /* Called locked. The strategy may block, so send unlocked with the entry
+     * pinned: close() waits for the pin before it frees the strategy */
+    entry.pins++;
+    k_mutex_unlock(&lock);
+
+    uint32_t start = k_cycle_get_32();
+    ssize_t  ret   = (count == 1) ? strategy->send(iov[0].iov_base, iov[0].iov_len) : strategy->sendv(iov, count);
+    int      err   = errno;
+    uint32_t us    = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+
+    k_mutex_lock(&lock, K_FOREVER);
+    unpin(entry);
+    errno = err;
+
+    /* log2 bucket: 0 us and 1 us land in bucket 0 */
+    size_t bucket = (us > 1) ? (31 - __builtin_clz(us)) : 0;
+    entry.traffic.latency[MIN(bucket, LATENCY_BUCKETS - 1)]++;
+
+    if (ret >= 0)
+    {
+        entry.traffic.packets++;
+        entry.traffic.bytes += ret;
+    }
+    else if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == ENOBUFS))
+    {
+        entry.traffic.eagain++;
+    }
+    else
+    {
+        entry.traffic.errors++;
+    }
+    return ret;
+}
+
+void socketManager::drainQueues()
+{
+    for (auto& entry : entries)
+    {
+        txItem* item = nullptr;
+
+        /* sendTimed() drops the lock around the send and pins the entry meanwhile */
+        k_mutex_lock(&lock, K_FOREVER);
+        while (entry.in_use && entry.async && (k_msgq_get(&entry.tx_queue, &item, K_NO_WAIT) == 0))
+        {
+            struct iovec iov = {item->data, item->len};
+            ssize_t      ret = sendTimed(entry, &iov, 1);
+            k_mem_slab_free(&socket_tx_slab, item);
+
+            if (ret < 0)
+            {
+                entry.tx.errors++;
+            }
+            else
+            {
+                entry.tx.sent++;
+            }
+        }
+        k_mutex_unlock(&lock);
+    }
+}
+
+ssize_t socketManager::receive(const std::string& host, protocol proto, uint16_t port, void* buffer, size_t maxLen)
+{
+    ssize_t ret = -1;
+
+    k_mutex_lock(&lock, K_FOREVER);
+    socketEntry* entry = find(proto, host, port);
+    if (entry)
+    {
+        ret = entry->strategy->receive(buffer, maxLen);
+    }
+    k_mutex_unlock(&lock);
+
+    return ret;
+}
+
+bool socketManager::setReceiveHandler(const std::string& host, protocol proto, uint16_t port, rxHandler handler,
+                                      void* ctx)
+{
+    bool ret = false;
+
+    k_mutex_lock(&lock, K_FOREVER);
+    socketEntry* entry = find(proto, host, port);
+    if (entry)
+    {
+        entry->handler     = handler;
+        entry->handler_ctx = ctx;
+        ret                = true;
+    }
+    k_mutex_unlock(&lock);
+
+    return ret;
+}
+
+bool socketManager::registerPortHandler(uint16_t port, rxHandler handler, void* ctx)
+{
+    bool ret = false;
+
+    k_mutex_lock(&lock, K_FOREVER);
+    for (auto& slot : port_handlers)
+    {
+        if ((slot.handler == nullptr) || (slot.port == port))
+        {
+            slot.port    = port;
+            slot.handler = handler;
+            slot.ctx     = ctx;
+            ret          = true;
+            break;
+        }
+    }
+    k_mutex_unlock(&lock);
+
+    if (!ret)
+    {
+        MYLOG("No free port handler slot for port %d", port);
+    }
     return ret;
 }
 
-ssize_t socketManager::receive(void* buffer, size_t maxLen)
+bool socketManager::watchFd(int fd, fdHandler handler, void* ctx)
 {
-    if (strategy)
+    bool ret = false;
+
+    if ((fd < 0) || (handler == nullptr))
+    {
+        return false;
+    }
+
+    k_mutex_lock(&lock, K_FOREVER);
+    for (auto& slot : fd_watchers)
+    {
+        if ((slot.fd < 0) || (slot.fd == fd))
+        {
+            slot.fd      = fd;
+            slot.handler = handler;
+            slot.ctx     = ctx;
+            ret          = true;
+            break;
+        }
+    }
+    k_mutex_unlock(&lock);
+
+    if (!ret)
+    {
+        MYLOG("No free watcher slot for fd %d", fd);
+        return false;
+    }
+
+    startWorker();
+    wakeWorker();
+    return true;
+}
+
+void socketManager::unwatchFd(int fd)
+{
+    k_mutex_lock(&lock, K_FOREVER);
+    for (auto& slot : fd_watchers)
+    {
+        if (slot.fd == fd)
+        {
+            slot = fdWatcher();
+        }
+    }
+    k_mutex_unlock(&lock);
+
+    wakeWorker();
+}
+
+size_t socketManager::getStats(socketInfo* out)
+{
+    size_t count = 0;
+
+    k_mutex_lock(&lock, K_FOREVER);
+    for (auto& entry : entries)
+    {
+        if (!entry.in_use)
+        {
+            continue;
+        }
+
+        socketInfo& info        = out[count++];
+        info.proto              = entry.proto;
+        info.host               = entry.host;
+        info.port               = entry.port;
+        info.async              = entry.async;
+        info.rx                 = entry.rx;
+        info.tx                 = entry.tx;
+        info.traffic            = entry.traffic;
+        info.traffic.reconnects = entry.strategy->getReconnects();
+        info.details[entry.strategy->formatStats(info.details, sizeof(info.details))] = '\0';
+    }
+    k_mutex_unlock(&lock);
+
+    return count;
+}
+
+size_t socketManager::formatStats(char* buffer, size_t len)
+{
+    socketInfo info[MAX_SOCKETS];
+    size_t     count = getStats(info);
+    size_t     used  = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const socketInfo& s = info[i];
+        int               n = snprintf(buffer + used, len - used,
+                                       "%s %s:%u tx=%u/%u eagain=%u err=%u rc=%u rx=%u/%u drop=%u lat=",
+                                       protocol_names[s.proto], s.host.c_str(), s.port, s.traffic.packets, s.traffic.bytes,
+                                       s.traffic.eagain, s.traffic.errors, s.traffic.reconnects, s.rx.packets, s.rx.bytes,
+                                       s.tx.dropped + s.rx.dropped);
+        for (size_t b = 0; (n > 0) && ((size_t)n < len - used) && (b < LATENCY_BUCKETS); b++)
+        {
+            n += snprintf(buffer + used + n, len - used - n, (b == 0) ? "%u" : ",%u", s.traffic.latency[b]);
+        }
+        if ((n > 0) && ((size_t)n < len - used) && (s.details[0] != '\0'))
+        {
+            n += snprintf(buffer + used + n, len - used - n, " %s", s.details);
+        }
+        if ((n < 0) || ((size_t)n + 1 >= len - used))
+        {
+            break;
+        }
+        buffer[used + n] = '\n';
+        used += n + 1;
+    }
+
+    if (used < len)
+    {
+        buffer[used] = '\0';
+    }
+    return used;
+}
+
+void socketManager::releaseRxBuffer(uint8_t* data)
+{
+    if (data)
+    {
+        k_mem_slab_free(&socket_rx_slab, data);
+    }
+}
+
+bool socketManager::getRxStats(const std::string& host, protocol proto, uint16_t port, rxStats& stats)
+{
+    bool ret = false;
+
+    k_mutex_lock(&lock, K_FOREVER);
+    socketEntry* entry = find(proto, host, port);
+    if (entry)
     {
-        return strategy->receive(buffer, maxLen);
+        stats = entry->rx;
+        ret   = true;
     }
-    return -1;
+    k_mutex_unlock(&lock);
+
+    return ret;
 }
 
 void socketManager::shutdown()
 {
-    if (strategy)
+    for (auto& entry : entries)
+    {
+        std::unique_ptr<socketStrategy> strategy;
+
+        k_mutex_lock(&lock, K_FOREVER);
+        if (entry.in_use)
+        {
+            release(entry, strategy);
+        }
+        k_mutex_unlock(&lock);
+
+        if (strategy)
+        {
+            strategy->disconnect();
+        }
+    }
+    wakeWorker();
+}
+
+socketManager::socketEntry* socketManager::find(protocol proto, const std::string& host, uint16_t port)
+{
+    for (auto& entry : entries)
     {
-        strategy->disconnect();
-        strategy.reset();
+        if (entry.in_use && (entry.proto == proto) && (entry.port == port) && (entry.host == host))
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void socketManager::startWorker()
+{
+    if (!atomic_cas(&worker_started, 0, 1))
+    {
+        return;
+    }
+
+    wake_fd = eventfd(0, EFD_NONBLOCK);
+    if (wake_fd < 0)
+    {
+        MYLOG("Socket worker wake-up unavailable: %d", errno);
+    }
+
+    /* Reconnects and unparked sockets rebuild the poll set at once */
+    socketStrategy::setFdChangedHandler(onFdChanged, this);
+
+    k_thread_create(&worker, socket_rx_stack, K_THREAD_STACK_SIZEOF(socket_rx_stack), workerThread, this, NULL,
+                    NULL, SOCKET_RX_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&worker, "socket_rx");
+}
+
+void socketManager::wakeWorker()
+{
+    if (wake_fd >= 0)
+    {
+        eventfd_write(wake_fd, 1);
+    }
+}
+
+void socketManager::onFdChanged(void* ctx)
+{
+    static_cast<socketManager*>(ctx)->wakeWorker();
+}
+
+void socketManager::serviceSocket(size_t index)
+{
+    uint8_t* buffer = nullptr;
+
+    k_mutex_lock(&lock, K_FOREVER);
+
+    socketEntry& entry = entries[index];
+    if (!entry.in_use)
+    {
+        k_mutex_unlock(&lock);
+        return;
+    }
+
+    if (k_mem_slab_alloc(&socket_rx_slab, (void**)&buffer, K_NO_WAIT) != 0)
+    {
+        /* Pool exhausted: drain the socket so poll does not spin */
+        entry.rx.overflow++;
+        entry.strategy->receive(rx_discard, sizeof(rx_discard));
+        k_mutex_unlock(&lock);
+        return;
+    }
+
+    ssize_t len = entry.strategy->receive(buffer, RX_BUF_SIZE);
+    if (len <= 0)
+    {
+        k_mutex_unlock(&lock);
+        releaseRxBuffer(buffer);
+        return;
+    }
+
+    rxHandler handler = entry.handler;
+    void*     ctx     = entry.handler_ctx;
+    if (handler == nullptr)
+    {
+        for (const auto& slot : port_handlers)
+        {
+            if ((slot.handler != nullptr) && (slot.port == entry.port))
+            {
+                handler = slot.handler;
+                ctx     = slot.ctx;
+                break;
+            }
+        }
+    }
+
+    if (handler == nullptr)
+    {
+        entry.rx.dropped++;
+        k_mutex_unlock(&lock);
+        releaseRxBuffer(buffer);
+        return;
+    }
+
+    entry.rx.packets++;
+    entry.rx.bytes += len;
+    k_mutex_unlock(&lock);
+
+    /* Handlers run unlocked so they are free to send or register */
+    if (!handler(buffer, len, ctx))
+    {
+        releaseRxBuffer(buffer);
+    }
+}
+
+void socketManager::serviceWatcher(size_t index)
+{
+    k_mutex_lock(&lock, K_FOREVER);
+    fdWatcher watcher = fd_watchers[index];
+    k_mutex_unlock(&lock);
+
+    /* Runs unlocked like the receive handlers, the owner does its own reads */
+    if (watcher.handler != nullptr)
+    {
+        watcher.handler(watcher.fd, watcher.ctx);
+    }
+}
+
+void socketManager::workerThread(void* p1, void*, void*)
+{
+    /* Index layout: sockets, then the wake-up eventfd, then watched descriptors */
+    constexpr size_t WAKE_INDEX = MAX_SOCKETS;
+    constexpr size_t POLL_SLOTS = MAX_SOCKETS + 1 + MAX_FD_WATCHERS;
+
+    socketManager* self = static_cast<socketManager*>(p1);
+    struct pollfd  fds[POLL_SLOTS];
+    size_t         index[POLL_SLOTS];
+
+    while (true)
+    {
+        nfds_t count = 0;
+
+        /* Async records are sent here, off the producers' threads */
+        self->drainQueues();
+
+        if (self->wake_fd >= 0)
+        {
+            fds[count].fd     = self->wake_fd;
+            fds[count].events = POLLIN;
+            index[count]      = WAKE_INDEX;
+            count++;
+        }
+
+        /* Snapshot the descriptors: a strategy whose descriptor changes wakes the poll to take a new one */
+        k_mutex_lock(&self->lock, K_FOREVER);
+        for (size_t i = 0; i < MAX_SOCKETS; i++)
+        {
+            int fd = self->entries[i].in_use ? self->entries[i].strategy->getFd() : -1;
+            if (fd >= 0)
+            {
+                fds[count].fd     = fd;
+                fds[count].events = POLLIN;
+                index[count]      = i;
+                count++;
+            }
+        }
+        for (size_t i = 0; i < MAX_FD_WATCHERS; i++)
+        {
+            if (self->fd_watchers[i].fd >= 0)
+            {
+                fds[count].fd     = self->fd_watchers[i].fd;
+                fds[count].events = POLLIN;
+                index[count]      = WAKE_INDEX + 1 + i;
+                count++;
+            }
+        }
+        k_mutex_unlock(&self->lock);
+
+        /* Idle until there is traffic, a queued record or a new descriptor */
+        int ret = poll(fds, count, (self->wake_fd >= 0) ? -1 : RX_POLL_TIMEOUT_MS);
+        if (ret < 0)
+        {
+            k_sleep(K_MSEC(RX_POLL_TIMEOUT_MS));
+            continue;
+        }
+
+        for (nfds_t i = 0; (i < count) && (ret > 0); i++)
+        {
+            if (fds[i].revents == 0)
+            {
+                continue;
+            }
+            ret--;
+
+            if (index[i] == WAKE_INDEX)
+            {
+                eventfd_t value;
+                eventfd_read(self->wake_fd, &value);
+            }
+            else if (index[i] > WAKE_INDEX)
+            {
+                self->serviceWatcher(index[i] - WAKE_INDEX - 1);
+            }
+            else
+            {
+                /* POLLHUP/POLLERR also go through receive() so the strategy sees the error */
+                self->serviceSocket(index[i]);
+            }
+        }
     }
 }
 
@@ -112,8 +865,61 @@ std::unique_ptr<socketStrategy> socketManager::createStrategy(socketManager::pro
             return std::make_unique<udpSocketStrategy>();
         case protocol::TLS:
             return std::make_unique<tlsSocketStrategy>();
+#if defined(CONFIG_APP_MQTT)
+        case protocol::MQTT:
+            return std::make_unique<mqttSocketStrategy>();
+#endif
         default:
             MYLOG("Unknown protocol type: %d", proto);
             return nullptr;
     }
 }
+
+#if defined(CONFIG_SHELL)
+static int cmdSocketsStats(const struct shell* sh, size_t argc, char** argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    socketManager::socketInfo info[socketManager::MAX_SOCKETS];
+    size_t                    count = socketManager::getInstance().getStats(info);
+
+    if (count == 0)
+    {
+        shell_print(sh, "No open sockets");
+        return 0;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const socketManager::socketInfo& s = info[i];
+
+        shell_print(sh, "%s %s:%u%s", protocol_names[s.proto], s.host.c_str(), s.port, s.async ? " (async)" : "");
+        shell_print(sh, "  send:  %u packets, %u bytes, %u eagain, %u errors, %u reconnects", s.traffic.packets,
+                    s.traffic.bytes, s.traffic.eagain, s.traffic.errors, s.traffic.reconnects);
+        shell_print(sh, "  recv:  %u packets, %u bytes, %u overflow, %u dropped", s.rx.packets, s.rx.bytes,
+                    s.rx.overflow, s.rx.dropped);
+        shell_print(sh, "  queue: %u queued, %u sent, %u dropped, %u errors, high water %u", s.tx.queued, s.tx.sent,
+                    s.tx.dropped, s.tx.errors, s.tx.high_water);
+        if (s.details[0] != '\0')
+        {
+            shell_print(sh, "  %s", s.details);
+        }
+        shell_print(sh, "  send latency:");
+        for (size_t b = 0; b < socketManager::LATENCY_BUCKETS; b++)
+        {
+            if (s.traffic.latency[b] > 0)
+            {
+                bool last = (b == socketManager::LATENCY_BUCKETS - 1);
+                shell_print(sh, "    %s%7u us: %u", last ? ">=" : "< ", 1U << (last ? b : b + 1), s.traffic.latency[b]);
+            }
+        }
+    }
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_sockets,
+                               SHELL_CMD(stats, NULL, "Per-socket traffic counters and send latency", cmdSocketsStats),
+                               SHELL_SUBCMD_SET_END);
+SHELL_CMD_REGISTER(sockets, &sub_sockets, "Socket manager commands", NULL);
+#endif
@@ -20,9 +20,10 @@
 #pragma once
 
 #include "socketStrategy.hpp"
+#include <zephyr/kernel.h>
+#include <array>
 #include <memory>
 #include <string>
-#include <map>
 
 class socketManager
 {
@@ -31,28 +32,321 @@ public:
     {
         TCP,
         UDP,
-        TLS
+        TLS,
+        MQTT /**< Telemetry records published to a broker, needs CONFIG_APP_MQTT */
     };
 
+    /**
+     * @brief Handler for received data, called on the network thread.
+     * @param data Buffer from the RX pool holding the received bytes.
+     * @param len Number of bytes received.
+     * @param ctx User context given at registration.
+     * @return true if the handler keeps the buffer and will return it with
+     *         releaseRxBuffer(), false to let the network thread free it.
+     */
+    using rxHandler = bool (*)(uint8_t* data, size_t len, void* ctx);
+
+    /**
+     * @brief Handler for a watched descriptor, called on the network thread when it is readable.
+     * @param fd The readable descriptor; the handler does the read itself.
+     * @param ctx User context given at registration.
+     */
+    using fdHandler = void (*)(int fd, void* ctx);
+
+    /**
+     * @brief Receive counters kept per socket.
+     */
+    struct rxStats
+    {
+        uint32_t packets;  /**< Datagrams/segments dispatched */
+        uint32_t bytes;    /**< Bytes dispatched */
+        uint32_t overflow; /**< Reads skipped because the RX pool was empty */
+        uint32_t dropped;  /**< Packets with no registered handler */
+    };
+
+    /**
+     * @brief What an async send does when the socket queue is full.
+     */
+    enum class overflowPolicy
+    {
+        DROP_OLDEST, /**< Discard the oldest queued record to make room */
+        DROP_NEWEST, /**< Reject the new record */
+        BLOCK        /**< Wait up to the configured timeout for room */
+    };
+
+    /**
+     * @brief Transmit queue counters kept per socket.
+     */
+    struct txStats
+    {
+        uint32_t queued;     /**< Records accepted into the queue */
+        uint32_t sent;       /**< Records handed to the strategy by the network thread */
+        uint32_t dropped;    /**< Records discarded by the overflow policy */
+        uint32_t errors;     /**< Records the strategy failed to send */
+        uint32_t high_water; /**< Highest queue depth observed */
+    };
+
+    /**
+     * @brief Buckets of the send latency histogram.
+     */
+    static constexpr size_t LATENCY_BUCKETS = 16;
+
+    /**
+     * @brief Traffic counters kept per socket, measured around the strategy send.
+     */
+    struct trafficStats
+    {
+        uint32_t packets;    /**< Records the strategy accepted */
+        uint32_t bytes;      /**< Bytes the strategy accepted */
+        uint32_t eagain;     /**< Sends refused for lack of room (EAGAIN, ENOBUFS) */
+        uint32_t errors;     /**< Sends failed for any other reason */
+        uint32_t reconnects; /**< Connections re-established by the strategy */
+        uint32_t latency[LATENCY_BUCKETS]; /**< Bucket n counts sends that took [2^n, 2^(n+1)) us, the last is open */
+    };
+
+    /**
+     * @brief Room for the strategy's own counters in a snapshot.
+     */
+    static constexpr size_t STRATEGY_STATS_LEN = 80;
+
+    /**
+     * @brief Snapshot of one open socket and all its counters.
+     */
+    struct socketInfo
+    {
+        protocol     proto;
+        std::string  host;
+        uint16_t     port;
+        bool         async;
+        rxStats      rx;
+        txStats      tx;
+        trafficStats traffic;
+        char         details[STRATEGY_STATS_LEN]; /**< Strategy counters (socketStrategy::formatStats()), or empty */
+    };
+
+    /**
+     * @brief Maximum number of concurrently open sockets.
+     */
+    static constexpr size_t MAX_SOCKETS = 8;
+
+    /**
+     * @brief Largest record accepted by an async send.
+     */
+    static constexpr size_t TX_BUF_SIZE = 512;
+
+    /**
+     * @brief Number of TX buffers shared by all async sockets.
+     */
+    static constexpr size_t TX_BUF_COUNT = 16;
+
+    /**
+     * @brief Depth of each per-socket async queue.
+     */
+    static constexpr size_t TX_QUEUE_DEPTH = 8;
+
+    /**
+     * @brief Record held in an async queue, allocated from the TX pool.
+     */
+    struct txItem
+    {
+        size_t  len;
+        uint8_t data[TX_BUF_SIZE];
+    };
+
+    /**
+     * @brief Size of each buffer in the RX pool.
+     */
+    static constexpr size_t RX_BUF_SIZE = 512;
+
+    /**
+     * @brief Number of buffers in the RX pool.
+     */
+    static constexpr size_t RX_BUF_COUNT = 4;
+
     static socketManager& getInstance();
 
     // bool init(protocol proto, const std::string& host, uint16_t port);
 
 
+    /**
+     * @brief Open a socket, or take another reference on an already open one.
+     * @note Users of the same (proto, host, port) share one strategy and one connection,
+     *       e.g. all sensors publishing through the MQTT broker.
+     * @return true if the socket is open.
+     */
     bool open(protocol proto, const std::string& host, uint16_t port);
-    void close(protocol proto, uint16_t port);
 
+    /**
+     * @brief Release a reference taken by open().
+     * @note The last release disconnects the strategy, drops its queued records and frees the slot.
+     */
+    void close(protocol proto, const std::string& host, uint16_t port);
+
+    /**
+     * @brief Send data on an open socket.
+     * @note For async sockets the data is copied into the socket queue and sent
+     *       by the network thread, so the call never waits on the link.
+     * @return Number of bytes sent or queued, -1 on error.
+     */
     ssize_t send(std::string& host, protocol proto, uint16_t port, const void* data, size_t len);
-    ssize_t receive(void* buffer, size_t maxLen);
+
+    /**
+     * @brief Send one record gathered from several buffers on an open socket.
+     * @note Sync sockets hand the iovec straight to the strategy (sendmsg), async
+     *       sockets gather it once into the TX buffer.
+     * @return Total number of bytes sent or queued, -1 on error.
+     */
+    ssize_t send(std::string& host, protocol proto, uint16_t port, const struct iovec* iov, size_t count);
+
+    /**
+     * @brief Switch a socket to async send mode.
+     * @param policy What to do when the queue is full.
+     * @param timeout_ms Maximum wait for overflowPolicy::BLOCK.
+     * @return true if the socket is open.
+     */
+    bool setAsync(const std::string& host, protocol proto, uint16_t port, overflowPolicy policy,
+                  uint32_t timeout_ms = 0);
+
+    /**
+     * @brief Get the transmit queue counters of a socket.
+     * @return true if the socket is open.
+     */
+    bool getTxStats(const std::string& host, protocol proto, uint16_t port, txStats& stats);
+
+    /**
+     * @brief Read directly from an open socket without blocking.
+     * @return Number of bytes read, or -1 if no socket is open or no data is pending.
+     */
+    ssize_t receive(const std::string& host, protocol proto, uint16_t port, void* buffer, size_t maxLen);
+
+    /**
+     * @brief Register a receive handler for one socket.
+     * @return true if the socket is open and the handler was set.
+     */
+    bool setReceiveHandler(const std::string& host, protocol proto, uint16_t port, rxHandler handler, void* ctx);
+
+    /**
+     * @brief Register a receive handler for every socket on a port.
+     * @note Per-socket handlers take precedence over port handlers.
+     * @return true if a free handler slot was available.
+     */
+    bool registerPortHandler(uint16_t port, rxHandler handler, void* ctx);
+
+    /**
+     * @brief Poll a descriptor owned by another module on the network thread.
+     * @note For services that need the peer address or their own framing (e.g. CoAP),
+     *       so they do not need a thread of their own.
+     * @return true if a free watcher slot was available.
+     */
+    bool watchFd(int fd, fdHandler handler, void* ctx);
+
+    /**
+     * @brief Stop polling a descriptor registered with watchFd().
+     */
+    void unwatchFd(int fd);
+
+    /**
+     * @brief Return a buffer kept by a receive handler to the RX pool.
+     */
+    void releaseRxBuffer(uint8_t* data);
+
+    /**
+     * @brief Get the receive counters of a socket.
+     * @return true if the socket is open.
+     */
+    bool getRxStats(const std::string& host, protocol proto, uint16_t port, rxStats& stats);
+
+    /**
+     * @brief Get a snapshot of every open socket.
+     * @param out Array with room for MAX_SOCKETS entries.
+     * @return Number of entries filled.
+     */
+    size_t getStats(socketInfo* out);
+
+    /**
+     * @brief Render the counters of every open socket as compact text, one line per socket.
+     * @note Used for the periodic stats packet.
+     * @return Number of characters written.
+     */
+    size_t formatStats(char* buffer, size_t len);
+
     void shutdown();
 
 private:
-    socketManager() = default;
+    socketManager();
 
-    using SocketKey = std::tuple<protocol, std::string, uint16_t>;
-    std::map<SocketKey, std::unique_ptr<socketStrategy>> sockets;
+    /**
+     * @brief Maximum number of port handlers.
+     */
+    static constexpr size_t MAX_PORT_HANDLERS = 4;
 
-    std::unique_ptr<socketStrategy> createStrategy(protocol proto, uint16_t port);
+    /**
+     * @brief Maximum number of descriptors watched for other modules.
+     */
+    static constexpr size_t MAX_FD_WATCHERS = 2;
+
+    /**
+     * @brief Poll timeout without the wake-up eventfd, and the pause after a failed poll.
+     * @note With the eventfd the network thread sleeps until traffic, a queued record or a descriptor change.
+     */
+    static constexpr int RX_POLL_TIMEOUT_MS = 1000;
+
+    struct socketEntry
+    {
+        bool                            in_use = false;
+        uint8_t                         refs   = 0;
+        uint8_t                         pins   = 0; /**< Calls using the entry with the lock dropped */
+        protocol                        proto  = UDP;
+        std::string                     host;
+        uint16_t                        port = 0;
+        std::unique_ptr<socketStrategy> strategy;
+        rxHandler                       handler     = nullptr;
+        void*                           handler_ctx = nullptr;
+        rxStats                         rx          = {};
+        bool                            async       = false;
+        overflowPolicy                  policy      = overflowPolicy::DROP_OLDEST;
+        k_timeout_t                     block_timeout;
+        struct k_msgq                   tx_queue;
+        void*                           tx_queue_buf[TX_QUEUE_DEPTH];
+        txStats                         tx = {};
+        trafficStats                    traffic = {};
+    };
+
+    struct portHandler
+    {
+        uint16_t  port    = 0;
+        rxHandler handler = nullptr;
+        void*     ctx     = nullptr;
+    };
+
+    struct fdWatcher
+    {
+        int       fd      = -1;
+        fdHandler handler = nullptr;
+        void*     ctx     = nullptr;
+    };
 
-    std::unique_ptr<socketStrategy> strategy;
+    struct k_mutex                             lock;
+    struct k_condvar                           unpinned; /**< Signalled when an entry's pins drop to zero */
+    std::array<socketEntry, MAX_SOCKETS>       entries;
+    std::array<portHandler, MAX_PORT_HANDLERS> port_handlers;
+    std::array<fdWatcher, MAX_FD_WATCHERS>     fd_watchers;
+    int                                        wake_fd = -1;
+    atomic_t                                   worker_started;
+    struct k_thread                            worker;
+
+    socketEntry* find(protocol proto, const std::string& host, uint16_t port);
+    void         release(socketEntry& entry, std::unique_ptr<socketStrategy>& strategy);
+    void         unpin(socketEntry& entry);
+    void         startWorker();
+    void         wakeWorker();
+    static void  onFdChanged(void* ctx);
+    void         serviceSocket(size_t index);
+    void         serviceWatcher(size_t index);
+    ssize_t      enqueue(socketEntry& entry, const struct iovec* iov, size_t count);
+    ssize_t      sendTimed(socketEntry& entry, const struct iovec* iov, size_t count);
+    void         drainQueues();
+    static void  workerThread(void*, void*, void*);
+
+    std::unique_ptr<socketStrategy> createStrategy(protocol proto, uint16_t port);
 };
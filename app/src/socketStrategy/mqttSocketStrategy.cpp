@@ -0,0 +1,558 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2024 Osama Salah-ud-din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "mqttSocketStrategy.hpp"
+#include "dnsCache.hpp"
+#include "myLogger.hpp"
+#include "reconnectPolicy.hpp"
+
+#include <zephyr/sys/util.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+mqttSocketStrategy::mqttSocketStrategy()
+{
+    k_mutex_init(&lock);
+    k_mutex_init(&queue_lock);
+    memset(pending, 0, sizeof(pending));
+    memset(inflight, 0, sizeof(inflight));
+    mqtt.owner    = this;
+    service.owner = this;
+    k_work_init_delayable(&service.work, serviceHandler);
+}
+
+mqttSocketStrategy::~mqttSocketStrategy()
+{
+    disconnect();
+}
+
+bool mqttSocketStrategy::connect(const std::string& _host, uint16_t _port)
+{
+    if (_host.empty())
+    {
+        MYLOG("Invalid MQTT broker");
+        return false;
+    }
+
+    dnsCache::getInstance().prefetch(_host);
+
+    k_mutex_lock(&lock, K_FOREVER);
+    host      = _host;
+    port      = _port;
+    is_active = true;
+    scheduleService(0);
+    unlockClient();
+    return true;
+}
+
+ssize_t mqttSocketStrategy::send(const void* data, size_t len)
+{
+    const char* record = static_cast<const char*>(data);
+    const char* sep    = static_cast<const char*>(memchr(record, ':', len));
+
+    if ((sep == nullptr) || (sep == record))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    int    id_len    = sep - record;
+    size_t value_len = len - id_len - 1;
+
+    message m = {};
+    int     n = snprintf(m.topic, sizeof(m.topic), "%s/%.*s", CONFIG_APP_MQTT_TOPIC_PREFIX, id_len, record);
+    if ((n >= (int)sizeof(m.topic)) || (value_len > sizeof(m.payload)))
+    {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    memcpy(m.payload, sep + 1, value_len);
+    m.len   = value_len;
+    m.stamp = k_uptime_get();
+    m.used  = true;
+
+    k_mutex_lock(&queue_lock, K_FOREVER);
+
+    /* Every reading carries its own sample time: keep them all, in order, and lose the oldest only on overflow */
+    if (pending_count == MAX_PENDING)
+    {
+        k_spinlock_key_t key = k_spin_lock(&stats_lock);
+        stats.dropped++;
+        k_spin_unlock(&stats_lock, key);
+        pending_head = (pending_head + 1) % MAX_PENDING;
+        pending_count--;
+    }
+    pending[(pending_head + pending_count) % MAX_PENDING] = m;
+    pending_count++;
+
+    /* Open a batch window unless one is already due sooner */
+    if (atomic_get(&connected) &&
+        (!k_work_delayable_is_pending(&service.work) ||
+         (k_ticks_to_ms_floor64(k_work_delayable_remaining_get(&service.work)) > BATCH_DELAY_MS)))
+    {
+        scheduleService(BATCH_DELAY_MS);
+    }
+
+    k_mutex_unlock(&queue_lock);
+    return len;
+}
+
+ssize_t mqttSocketStrategy::sendv(const struct iovec* iov, size_t count)
+{
+    /* A record has to be parsed into topic and payload, so gather it on the stack */
+    char   record[TOPIC_MAX_LEN + PAYLOAD_MAX_LEN];
+    size_t len = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (iov[i].iov_len > sizeof(record) - len)
+        {
+            errno = EMSGSIZE;
+            return -1;
+        }
+        memcpy(record + len, iov[i].iov_base, iov[i].iov_len);
+        len += iov[i].iov_len;
+    }
+
+    return send(record, len);
+}
+
+ssize_t mqttSocketStrategy::receive(void* buffer, size_t maxLen)
+{
+    ARG_UNUSED(buffer);
+    ARG_UNUSED(maxLen);
+
+    /* The work queue may be inside a blocking publish, do not stall the network thread on it */
+    if (k_mutex_lock(&lock, K_NO_WAIT) != 0)
+    {
+        /* Leave the unread data alone without poll() firing on it again, unlockClient() takes it back.
+         * Retry once in case the holder released the lock before the socket was parked. */
+        atomic_set(&parked, 1);
+        if (k_mutex_lock(&lock, K_NO_WAIT) != 0)
+        {
+            return 0;
+        }
+    }
+
+    if (st != state::IDLE)
+    {
+        /* Errors are reported through MQTT_EVT_DISCONNECT */
+        mqtt_input(&mqtt.client);
+    }
+
+    unlockClient();
+    return 0;
+}
+
+void mqttSocketStrategy::unlockClient() const
+{
+    k_mutex_unlock(&lock);
+
+    /* The next poll set built by the network thread includes the socket again: build it now */
+    if (atomic_set(&parked, 0))
+    {
+        fdChanged();
+    }
+}
+
+void mqttSocketStrategy::disconnect()
+{
+    struct k_work_sync sync;
+
+    k_mutex_lock(&lock, K_FOREVER);
+    is_active = false;
+    unlockClient();
+
+    k_work_cancel_delayable_sync(&service.work, &sync);
+
+    k_mutex_lock(&lock, K_FOREVER);
+    abortConnection();
+    reconnect_attempts = 0;
+    unlockClient();
+}
+
+int mqttSocketStrategy::getFd() const
+{
+    return atomic_get(&parked) ? -1 : atomic_get(&fd);
+}
+
+uint32_t mqttSocketStrategy::getReconnects() const
+{
+    atomic_val_t count = atomic_get(&connects);
+    return (count > 0) ? (count - 1) : 0;
+}
+
+mqttSocketStrategy::mqttStats mqttSocketStrategy::getStats() const
+{
+    k_spinlock_key_t key      = k_spin_lock(&stats_lock);
+    mqttStats        snapshot = stats;
+    k_spin_unlock(&stats_lock, key);
+    return snapshot;
+}
+
+size_t mqttSocketStrategy::formatStats(char* buffer, size_t len) const
+{
+    mqttStats s   = getStats();
+    uint32_t  avg = (s.acked > 0) ? (uint32_t)(s.ack_total_ms / s.acked) : 0;
+
+    int n = snprintf(buffer, len, "mqtt pub=%u ack=%u drop=%u retx=%u ack_ms=%u/%u/%u", s.published, s.acked,
+                     s.dropped, s.retransmits, s.ack_min_ms, avg, s.ack_max_ms);
+    return ((n < 0) || (len == 0)) ? 0 : MIN((size_t)n, len - 1);
+}
+
+bool mqttSocketStrategy::tryConnect()
+{
+    struct sockaddr addr;
+    socklen_t       addrlen;
+
+    if (dnsCache::getInstance().lookup(host, port, addr, addrlen) < 0)
+    {
+        MYLOG("MQTT broker %s not resolved yet", host.c_str());
+        return false;
+    }
+    memcpy(&broker, &addr, addrlen);
+
+    struct mqtt_client* client = &mqtt.client;
+    mqtt_client_init(client);
+
+    client->broker           = &broker;
+    client->evt_cb           = eventHandler;
+    client->client_id.utf8   = (const uint8_t*)CONFIG_APP_MQTT_CLIENT_ID;
+    client->client_id.size   = strlen(CONFIG_APP_MQTT_CLIENT_ID);
+    client->password         = nullptr;
+    client->user_name        = nullptr;
+    client->protocol_version = MQTT_VERSION_3_1_1;
+    client->clean_session    = 0;
+    client->rx_buf           = rx_buf;
+    client->rx_buf_size      = sizeof(rx_buf);
+    client->tx_buf           = tx_buf;
+    client->tx_buf_size      = sizeof(tx_buf);
+    client->transport.type   = MQTT_TRANSPORT_NON_SECURE;
+
+    /* Blocks for the TCP connect; producers only need queue_lock meanwhile */
+    int ret = mqtt_connect(client);
+    if (ret < 0)
+    {
+        MYLOG("MQTT connect to %s:%d failed: %d", host.c_str(), port, ret);
+        dnsCache::getInstance().reportFailure(host, addr);
+        return false;
+    }
+
+    /* The network thread picks the socket up on its next poll and delivers CONNACK */
+    st              = state::CONNECTING;
+    connack_failed  = false;
+    connect_started = k_uptime_get();
+    atomic_set(&fd, client->transport.tcp.sock);
+    fdChanged();
+    return true;
+}
+
+void mqttSocketStrategy::abortConnection()
+{
+    bool open = (st != state::IDLE);
+
+    /* Go idle first so the MQTT_EVT_DISCONNECT raised by the abort is ignored */
+    st = state::IDLE;
+    atomic_set(&fd, -1);
+    atomic_set(&connected, 0);
+    fdChanged();
+
+    if (open)
+    {
+        /* Abort instead of DISCONNECT: the broker keeps the persistent session either way */
+        mqtt_abort(&mqtt.client);
+    }
+
+    if (is_active)
+    {
+        scheduleService(nextBackoff());
+    }
+}
+
+bool mqttSocketStrategy::publish(const message& m, bool qos1, bool dup)
+{
+    struct mqtt_publish_param param = {};
+
+    param.message.topic.topic.utf8 = (const uint8_t*)m.topic;
+    param.message.topic.topic.size = strlen(m.topic);
+    param.message.topic.qos        = qos1 ? MQTT_QOS_1_AT_LEAST_ONCE : MQTT_QOS_0_AT_MOST_ONCE;
+    param.message.payload.data     = (uint8_t*)m.payload;
+    param.message.payload.len      = m.len;
+    param.message_id               = m.id;
+    param.dup_flag                 = dup ? 1 : 0;
+    param.retain_flag              = 0;
+
+    int ret = mqtt_publish(&mqtt.client, &param);
+    if (ret < 0)
+    {
+        MYLOG("MQTT publish to %s failed: %d", m.topic, ret);
+        return false;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+    stats.published++;
+    k_spin_unlock(&stats_lock, key);
+    return true;
+}
+
+bool mqttSocketStrategy::takePending(message& out)
+{
+    k_mutex_lock(&queue_lock, K_FOREVER);
+
+    bool found = (pending_count > 0);
+    if (found)
+    {
+        out          = pending[pending_head];
+        pending_head = (pending_head + 1) % MAX_PENDING;
+        pending_count--;
+    }
+
+    k_mutex_unlock(&queue_lock);
+    return found;
+}
+
+void mqttSocketStrategy::publishPending()
+{
+    bool qos1 = (CONFIG_APP_MQTT_QOS == 1);
+
+    while (st == state::CONNECTED)
+    {
+        message* slot = nullptr;
+        if (qos1)
+        {
+            for (auto& f : inflight)
+            {
+                if (!f.used)
+                {
+                    slot = &f;
+                    break;
+                }
+            }
+
+            /* Window full: the rest waits for PUBACKs */
+            if (slot == nullptr)
+            {
+                return;
+            }
+        }
+
+        message m;
+        if (!takePending(m))
+        {
+            return;
+        }
+
+        /* Message id 0 is reserved */
+        next_id = (next_id == UINT16_MAX) ? 1 : (next_id + 1);
+        m.id    = next_id;
+        m.stamp = k_uptime_get();
+
+        if (!publish(m, qos1, false))
+        {
+            abortConnection();
+            return;
+        }
+
+        if (slot != nullptr)
+        {
+            *slot = m;
+        }
+    }
+}
+
+void mqttSocketStrategy::resendInflight(bool all)
+{
+    int64_t now = k_uptime_get();
+
+    for (auto& f : inflight)
+    {
+        if (!f.used || (!all && (now - f.stamp < ACK_TIMEOUT_MS)))
+        {
+            continue;
+        }
+
+        f.stamp = now;
+
+        k_spinlock_key_t key = k_spin_lock(&stats_lock);
+        stats.retransmits++;
+        k_spin_unlock(&stats_lock, key);
+
+        if (!publish(f, true, true))
+        {
+            abortConnection();
+            return;
+        }
+    }
+}
+
+void mqttSocketStrategy::scheduleService(uint32_t delay_ms)
+{
+    k_work_reschedule_for_queue(workQueue(), &service.work, K_MSEC(delay_ms));
+}
+
+uint32_t mqttSocketStrategy::nextBackoff()
+{
+    uint32_t shift = MIN(reconnect_attempts, 16U);
+    uint32_t delay = MIN(RECONNECT_BASE_MS << shift, RECONNECT_MAX_MS);
+    reconnect_attempts++;
+    return reconnectPolicy::equalJitter(delay);
+}
+
+void mqttSocketStrategy::onEvent(const struct mqtt_evt& evt)
+{
+    switch (evt.type)
+    {
+        case MQTT_EVT_CONNACK:
+            if (evt.result != 0)
+            {
+                MYLOG("MQTT broker refused connection: %d", evt.result);
+                connack_failed = true;
+                scheduleService(0);
+                break;
+            }
+            MYLOG("MQTT connected to %s:%d (session %s)", host.c_str(), port,
+                  evt.param.connack.session_present_flag ? "resumed" : "new");
+            st                 = state::CONNECTED;
+            reconnect_attempts = 0;
+            resend_all         = true;
+            atomic_set(&connected, 1);
+            atomic_inc(&connects);
+            scheduleService(0);
+            break;
+
+        case MQTT_EVT_PUBACK:
+            for (auto& f : inflight)
+            {
+                if (f.used && (f.id == evt.param.puback.message_id))
+                {
+                    uint32_t         elapsed = (uint32_t)(k_uptime_get() - f.stamp);
+                    k_spinlock_key_t key     = k_spin_lock(&stats_lock);
+                    stats.acked++;
+                    stats.ack_total_ms += elapsed;
+                    stats.ack_max_ms = MAX(stats.ack_max_ms, elapsed);
+                    stats.ack_min_ms = (stats.acked == 1) ? elapsed : MIN(stats.ack_min_ms, elapsed);
+                    k_spin_unlock(&stats_lock, key);
+                    f.used = false;
+                    break;
+                }
+            }
+            /* A slot opened in the window */
+            scheduleService(0);
+            break;
+
+        case MQTT_EVT_DISCONNECT:
+            if (st == state::IDLE)
+            {
+                /* Raised by our own abortConnection() */
+                break;
+            }
+            MYLOG("MQTT disconnected from %s:%d: %d", host.c_str(), port, evt.result);
+            st = state::IDLE;
+            atomic_set(&fd, -1);
+            atomic_set(&connected, 0);
+            fdChanged();
+            if (is_active)
+            {
+                scheduleService(nextBackoff());
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void mqttSocketStrategy::eventHandler(struct mqtt_client* client, const struct mqtt_evt* evt)
+{
+    clientWrapper* wrapper = CONTAINER_OF(client, clientWrapper, client);
+
+    /* Runs inside mqtt_input()/mqtt_abort(), the strategy lock is already held */
+    wrapper->owner->onEvent(*evt);
+}
+
+void mqttSocketStrategy::serviceHandler(struct k_work* work)
+{
+    struct k_work_delayable* dwork = k_work_delayable_from_work(work);
+    serviceWork*             item  = CONTAINER_OF(dwork, serviceWork, work);
+    mqttSocketStrategy*      self  = item->owner;
+
+    k_mutex_lock(&self->lock, K_FOREVER);
+
+    if (!self->is_active)
+    {
+        self->unlockClient();
+        return;
+    }
+
+    switch (self->st)
+    {
+        case state::IDLE:
+            if (self->tryConnect())
+            {
+                self->scheduleService(CONNACK_TIMEOUT_MS);
+            }
+            else
+            {
+                self->scheduleService(self->nextBackoff());
+            }
+            break;
+
+        case state::CONNECTING:
+            if (self->connack_failed || (k_uptime_get() - self->connect_started >= CONNACK_TIMEOUT_MS))
+            {
+                MYLOG("MQTT %s:%d no usable CONNACK, reconnecting", self->host.c_str(), self->port);
+                self->abortConnection();
+            }
+            else
+            {
+                self->scheduleService(CONNACK_TIMEOUT_MS - (k_uptime_get() - self->connect_started));
+            }
+            break;
+
+        case state::CONNECTED:
+        {
+            /* Unacked messages are resent on every new connection, later only after a timeout */
+            self->resendInflight(self->resend_all);
+            self->resend_all = false;
+            self->publishPending();
+            if (self->st != state::CONNECTED)
+            {
+                break;
+            }
+
+            mqtt_live(&self->mqtt.client);
+
+            /* Wake for the next keepalive, or sooner to check ack timeouts */
+            int64_t next = mqtt_keepalive_time_left(&self->mqtt.client);
+            for (const auto& f : self->inflight)
+            {
+                if (f.used)
+                {
+                    next = MIN(next, ACK_TIMEOUT_MS);
+                    break;
+                }
+            }
+            self->scheduleService((uint32_t)next);
+            break;
+        }
+    }
+
+    self->unlockClient();
+}
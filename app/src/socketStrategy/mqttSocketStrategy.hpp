@@ -0,0 +1,228 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2024 Osama Salah-ud-din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "socketStrategy.hpp"
+#include <zephyr/kernel.h>
+#include <zephyr/net/mqtt.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/sys/atomic.h>
+#include <string>
+
+/**
+ * @brief MQTT telemetry strategy over one persistent broker connection.
+ * @note send() takes the telemetry record "id:value", where value may end in an
+ *       "@epoch_us" sample stamp, and publishes value to
+ *       "<CONFIG_APP_MQTT_TOPIC_PREFIX>/<id>". Records wait in a FIFO pending
+ *       queue that drops its oldest record only when full, and are published
+ *       in order, in batches, from the socket work queue. QoS 1
+ *       messages stay in a bounded in-flight window until the broker acks
+ *       them, and are resent with the DUP flag after a timeout or reconnect.
+ *       The session is persistent (clean session off).
+ */
+class mqttSocketStrategy : public socketStrategy
+{
+public:
+    /**
+     * @brief Publish and acknowledgement statistics.
+     */
+    struct mqttStats
+    {
+        uint32_t published;    /**< PUBLISH packets written, including resends */
+        uint32_t acked;        /**< QoS 1 messages acknowledged by the broker */
+        uint32_t dropped;      /**< Oldest records discarded because the pending queue was full */
+        uint32_t retransmits;  /**< QoS 1 messages resent with the DUP flag */
+        uint32_t ack_min_ms;   /**< Fastest PUBLISH to PUBACK time */
+        uint32_t ack_max_ms;   /**< Slowest PUBLISH to PUBACK time */
+        uint64_t ack_total_ms; /**< Sum of all PUBLISH to PUBACK times */
+    };
+
+    mqttSocketStrategy();
+    ~mqttSocketStrategy() override;
+
+    /**
+     * @brief Start the broker connection in the background.
+     * @return false only if the host is empty.
+     */
+    bool connect(const std::string& host, uint16_t port) override;
+
+    /**
+     * @brief Queue a telemetry record for publishing.
+     * @note A full queue discards its oldest record to make room, counted in mqttStats::dropped.
+     * @return len when queued, -1 with errno EINVAL (not "id:value") or EMSGSIZE.
+     */
+    ssize_t send(const void* data, size_t len) override;
+
+    /**
+     * @brief Queue a telemetry record given in pieces, e.g. id, ':' and value.
+     */
+    ssize_t sendv(const struct iovec* iov, size_t count) override;
+
+    /**
+     * @brief Process incoming broker packets (CONNACK, PUBACK, PINGRESP).
+     * @note Called by the socketManager network thread when the socket is readable.
+     *       Never returns application data. If the work queue holds the client,
+     *       e.g. in a blocking publish, the socket is parked: getFd() returns -1
+     *       so poll() does not spin on it, until the holder releases the client.
+     */
+    ssize_t receive(void* buffer, size_t maxLen) override;
+
+    void     disconnect() override;
+    int      getFd() const override;
+    uint32_t getReconnects() const override;
+
+    /**
+     * @brief Get a snapshot of the publish statistics.
+     */
+    mqttStats getStats() const;
+
+    /**
+     * @brief Publish statistics for the socketManager report: published, acked, dropped, retransmits and the
+     *        min/avg/max PUBLISH to PUBACK time in ms.
+     */
+    size_t formatStats(char* buffer, size_t len) const override;
+
+private:
+    /**
+     * @brief Records waiting to be published, enough to ride out a short broker outage.
+     */
+    static constexpr size_t MAX_PENDING = 16;
+
+    /**
+     * @brief Unacknowledged QoS 1 messages allowed at once.
+     */
+    static constexpr size_t MAX_INFLIGHT = 4;
+
+    /**
+     * @brief Longest topic, including the prefix.
+     */
+    static constexpr size_t TOPIC_MAX_LEN = 48;
+
+    /**
+     * @brief Longest published value.
+     */
+    static constexpr size_t PAYLOAD_MAX_LEN = 32;
+
+    /**
+     * @brief Size of each of the MQTT client RX and TX buffers.
+     */
+    static constexpr size_t CLIENT_BUF_SIZE = 256;
+
+    /**
+     * @brief Time records are collected before a batch is published.
+     */
+    static constexpr uint32_t BATCH_DELAY_MS = 50;
+
+    /**
+     * @brief Time without PUBACK before a QoS 1 message is resent.
+     */
+    static constexpr int64_t ACK_TIMEOUT_MS = 5000;
+
+    /**
+     * @brief Time allowed for the broker to answer CONNECT.
+     */
+    static constexpr int64_t CONNACK_TIMEOUT_MS = 5000;
+
+    /**
+     * @brief First and largest reconnect delay in milliseconds.
+     */
+    static constexpr uint32_t RECONNECT_BASE_MS = 500;
+    static constexpr uint32_t RECONNECT_MAX_MS  = 30000;
+
+    enum class state
+    {
+        IDLE,
+        CONNECTING,
+        CONNECTED
+    };
+
+    struct message
+    {
+        char     topic[TOPIC_MAX_LEN];
+        uint8_t  payload[PAYLOAD_MAX_LEN];
+        size_t   len;
+        uint16_t id;
+        int64_t  stamp; /**< Queue time while pending, send time while in flight */
+        bool     used;  /**< In-flight slot taken */
+    };
+
+    /**
+     * @brief Client wrapper so the event callback can find its strategy.
+     */
+    struct clientWrapper
+    {
+        struct mqtt_client  client;
+        mqttSocketStrategy* owner;
+    };
+
+    /**
+     * @brief Work item wrapper so the handler can find its strategy.
+     */
+    struct serviceWork
+    {
+        struct k_work_delayable work;
+        mqttSocketStrategy*     owner;
+    };
+
+    /* lock guards the client and the in-flight window, queue_lock the pending queue */
+    mutable struct k_mutex  lock;
+    mutable struct k_mutex  queue_lock;
+    clientWrapper           mqtt;
+    struct sockaddr_storage broker;
+    uint8_t                 rx_buf[CLIENT_BUF_SIZE];
+    uint8_t                 tx_buf[CLIENT_BUF_SIZE];
+    std::string             host;
+    uint16_t                port = 0;
+    bool                    is_active = false;
+    state                   st = state::IDLE;
+    bool                    connack_failed = false;
+    bool                    resend_all = false;
+    atomic_t                fd = ATOMIC_INIT(-1);
+    mutable atomic_t        parked = ATOMIC_INIT(0); /**< Socket left out of the poll set while lock is busy */
+    atomic_t                connected = ATOMIC_INIT(0);
+    int64_t                 connect_started = 0;
+    uint16_t                next_id = 0;
+    uint32_t                reconnect_attempts = 0;
+    atomic_t                connects = ATOMIC_INIT(0);
+    message                 pending[MAX_PENDING];
+    size_t                  pending_head = 0;
+    size_t                  pending_count = 0;
+    message                 inflight[MAX_INFLIGHT];
+    serviceWork             service;
+
+    /* Written under lock or queue_lock, read by any thread: stats_lock keeps a snapshot whole without waiting on
+     * the client, which a blocking publish may hold */
+    mutable struct k_spinlock stats_lock = {};
+    mqttStats                 stats      = {};
+
+    bool     tryConnect();
+    void     abortConnection();
+    void     publishPending();
+    void     resendInflight(bool all);
+    bool     publish(const message& m, bool qos1, bool dup);
+    bool     takePending(message& out);
+    void     unlockClient() const;
+    void     scheduleService(uint32_t delay_ms);
+    uint32_t nextBackoff();
+    void     onEvent(const struct mqtt_evt& evt);
+
+    static void eventHandler(struct mqtt_client* client, const struct mqtt_evt* evt);
+    static void serviceHandler(struct k_work* work);
+};
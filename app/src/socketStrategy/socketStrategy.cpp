@@ -18,120 +18,777 @@
  */
 
 #include "socketStrategy.hpp"
+#include <zephyr/init.h>
 #include <zephyr/net/socket.h>
+#include <zephyr/net/tls_credentials.h>
 #include <zephyr/posix/arpa/inet.h>
+#include <zephyr/posix/fcntl.h>
+#include <zephyr/sys/util.h>
 #include <unistd.h>
+#include <cerrno>
 #include <cstring>
 
 #include"myLogger.hpp"
+#include "dnsCache.hpp"
+#include "reconnectPolicy.hpp"
 
 
 // ================= TCP =================
-bool tcpSocketStrategy::connect(const std::string& host, uint16_t port)
+/* Dedicated work queue so blocking connects never stall the system work queue */
+K_THREAD_STACK_DEFINE(socket_wq_stack, 3072);
+static struct k_work_q socket_wq;
+
+/* Started at boot: a queue that is not running yet rejects submissions, and the work would be lost */
+static int socketWorkQueueInit()
 {
-    struct sockaddr_in addr = {};
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
-    inet_pton(AF_INET, host.c_str(), &addr.sin_addr);
+    k_work_queue_start(&socket_wq, socket_wq_stack, K_THREAD_STACK_SIZEOF(socket_wq_stack), K_PRIO_PREEMPT(8),
+                       NULL);
+    k_thread_name_set(&socket_wq.thread, "socket_wq");
+    return 0;
+}
 
-    sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (sock < 0)
-        return false;
+SYS_INIT(socketWorkQueueInit, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+
+/* Set once by socketManager before its network thread starts */
+static socketStrategy::fdChangedHandler fd_changed_handler = nullptr;
+static void*                            fd_changed_ctx     = nullptr;
 
-    int ret = ::connect(sock, (struct sockaddr*)&addr, sizeof(addr));
-    if (ret < 0)
+void socketStrategy::setFdChangedHandler(fdChangedHandler handler, void* ctx)
+{
+    fd_changed_ctx     = ctx;
+    fd_changed_handler = handler;
+}
+
+void socketStrategy::fdChanged()
+{
+    if (fd_changed_handler != nullptr)
     {
-        sock = -1;
-        MYLOG("Failed to connect to %s:%d return Code:%d", host.c_str(), port, ret);
-        return false;
+        fd_changed_handler(fd_changed_ctx);
     }
-    else
+}
+
+size_t socketStrategy::totalLength(const struct iovec* iov, size_t count)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++)
     {
-        return true;
+        total += iov[i].iov_len;
+    }
+    return total;
+}
+
+struct k_work_q* socketStrategy::workQueue()
+{
+    return &socket_wq;
+}
+
+tcpSocketStrategy::tcpSocketStrategy()
+{
+    k_mutex_init(&lock);
+    ring_buf_init(&tx_ring, sizeof(tx_storage), tx_storage);
+    service.owner = this;
+    k_work_init_delayable(&service.work, serviceHandler);
+}
+
+tcpSocketStrategy::~tcpSocketStrategy()
+{
+    disconnect();
+}
+
+bool tcpSocketStrategy::connect(const std::string& _host, uint16_t _port)
+{
+    if (_host.empty())
+    {
+        MYLOG("Invalid TCP host");
+        return false;
     }
+
+    /* Start resolving now, tryConnect() picks the address up from the cache */
+    dnsCache::getInstance().prefetch(_host);
+
+    /* The caller may hold the socketManager lock: the first connect runs on the work queue like every reconnect,
+     * records sent meanwhile are queued */
+    k_mutex_lock(&lock, K_FOREVER);
+    host = _host;
+    port = _port;
+    is_active = true;
+    scheduleService(0);
+    k_mutex_unlock(&lock);
+    return true;
 }
 
 ssize_t tcpSocketStrategy::send(const void* data, size_t len)
 {
-    return ::send(sock, data, len, 0);
+    struct iovec iov = {const_cast<void*>(data), len};
+    return sendv(&iov, 1);
+}
+
+ssize_t tcpSocketStrategy::sendv(const struct iovec* iov, size_t count)
+{
+    size_t total = totalLength(iov, count);
+    size_t sent  = 0;
+
+    k_mutex_lock(&lock, K_FOREVER);
+
+    /* Refuse before any byte reaches the stream: the remainder of a partial write must always fit */
+    if (ring_buf_space_get(&tx_ring) < total)
+    {
+        dropped_records++;
+        MYLOG("TCP %s:%d queue full, dropped %u records", host.c_str(), port, dropped_records);
+        k_mutex_unlock(&lock);
+        errno = ENOBUFS;
+        return -1;
+    }
+
+    /* Keep ordering: only write directly when nothing is queued, nor claimed by a flush in progress */
+    if ((sock >= 0) && !flushing && ring_buf_is_empty(&tx_ring))
+    {
+        struct msghdr msg = {};
+        msg.msg_iov       = const_cast<struct iovec*>(iov);
+        msg.msg_iovlen    = count;
+
+        ssize_t ret = sendmsg(sock, &msg, MSG_DONTWAIT);
+        if (ret == (ssize_t)total)
+        {
+            k_mutex_unlock(&lock);
+            return ret;
+        }
+
+        if (ret >= 0)
+        {
+            /* Partial write, queue the remainder */
+            sent = ret;
+        }
+        else if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+        {
+            handleLinkLoss(errno);
+        }
+    }
+
+    /* Part of the record may be on the wire already, the rest is committed to the queue */
+    enqueue(iov, count, sent);
+    bool connected = (sock >= 0);
+    k_mutex_unlock(&lock);
+
+    if (connected)
+    {
+        scheduleService(0);
+    }
+    return total;
 }
 
 ssize_t tcpSocketStrategy::receive(void* buffer, size_t maxLen)
 {
-    return ::recv(sock, buffer, maxLen, 0);
+    k_mutex_lock(&lock, K_FOREVER);
+    int fd = sock;
+    k_mutex_unlock(&lock);
+
+    if (fd < 0)
+    {
+        errno = ENOTCONN;
+        return -1;
+    }
+
+    ssize_t ret = ::recv(fd, buffer, maxLen, MSG_DONTWAIT);
+    if ((ret == 0) || ((ret < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK)))
+    {
+        /* Orderly shutdown or reset by the peer */
+        int err = (ret == 0) ? ECONNRESET : errno;
+        k_mutex_lock(&lock, K_FOREVER);
+        if (fd == sock)
+        {
+            handleLinkLoss(err);
+        }
+        k_mutex_unlock(&lock);
+    }
+    return ret;
+}
+
+int tcpSocketStrategy::getFd() const
+{
+    k_mutex_lock(&lock, K_FOREVER);
+    int fd = sock;
+    k_mutex_unlock(&lock);
+    return fd;
 }
 
 void tcpSocketStrategy::disconnect()
+{
+    struct k_work_sync sync;
+
+    k_mutex_lock(&lock, K_FOREVER);
+    is_active = false;
+    k_mutex_unlock(&lock);
+
+    k_work_cancel_delayable_sync(&service.work, &sync);
+
+    k_mutex_lock(&lock, K_FOREVER);
+    closeSocket();
+    ring_buf_reset(&tx_ring);
+    reconnect_attempts = 0;
+    k_mutex_unlock(&lock);
+}
+
+uint32_t tcpSocketStrategy::getReconnects() const
+{
+    k_mutex_lock(&lock, K_FOREVER);
+    uint32_t count = (connects > 0) ? (connects - 1) : 0;
+    k_mutex_unlock(&lock);
+    return count;
+}
+
+bool tcpSocketStrategy::isConnected() const
+{
+    k_mutex_lock(&lock, K_FOREVER);
+    bool connected = (sock >= 0);
+    k_mutex_unlock(&lock);
+    return connected;
+}
+
+int tcpSocketStrategy::openSocket(sa_family_t family)
+{
+    int fd = socket(family, SOCK_STREAM, IPPROTO_TCP);
+    if (fd >= 0)
+    {
+        enableKeepalive(fd);
+    }
+    return fd;
+}
+
+void tcpSocketStrategy::onConnectAttempt(bool success, int64_t elapsed_ms)
+{
+    ARG_UNUSED(success);
+    ARG_UNUSED(elapsed_ms);
+}
+
+void tcpSocketStrategy::enableKeepalive(int fd)
+{
+    int one   = 1;
+    int idle  = KEEPALIVE_IDLE_S;
+    int intvl = KEEPALIVE_INTVL_S;
+    int cnt   = KEEPALIVE_CNT;
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &intvl, sizeof(intvl));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &cnt, sizeof(cnt));
+}
+
+bool tcpSocketStrategy::tryConnect()
+{
+    struct sockaddr dest[dnsCache::MAX_CANDIDATES];
+    socklen_t       destlen[dnsCache::MAX_CANDIDATES];
+
+    /* Never waits on DNS: an unresolved host is simply retried with backoff */
+    int count = dnsCache::getInstance().candidates(host, port, dest, destlen);
+    if (count < 0)
+    {
+        MYLOG("TCP %s:%d not resolved yet", host.c_str(), port);
+        return false;
+    }
+
+    /* The connect runs unlocked so producers can keep queueing */
+    int     winner = -1;
+    int64_t start  = k_uptime_get();
+    int     fd     = raceConnect(dest, destlen, count, winner);
+    onConnectAttempt(fd >= 0, k_uptime_get() - start);
+
+    if (fd < 0)
+    {
+        MYLOG("Failed to connect to %s:%d", host.c_str(), port);
+        for (int i = 0; i < count; i++)
+        {
+            dnsCache::getInstance().reportFailure(host, dest[i]);
+        }
+        return false;
+    }
+
+    if (count > 1)
+    {
+        dnsCache::getInstance().setPreferredFamily(host, dest[winner].sa_family);
+    }
+
+    k_mutex_lock(&lock, K_FOREVER);
+    if (!is_active)
+    {
+        /* disconnect() was called while we were connecting */
+        k_mutex_unlock(&lock);
+        close(fd);
+        return false;
+    }
+
+    sock = fd;
+    connects++;
+    fdChanged();
+    if (reconnect_attempts > 0)
+    {
+        MYLOG("TCP %s:%d reconnected after %u attempts", host.c_str(), port, reconnect_attempts);
+    }
+    reconnect_attempts = 0;
+    k_mutex_unlock(&lock);
+    return true;
+}
+
+int tcpSocketStrategy::startConnect(const struct sockaddr& dest, socklen_t destlen)
+{
+    int fd = openSocket(dest.sa_family);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    if ((::connect(fd, &dest, destlen) < 0) && (errno != EINPROGRESS))
+    {
+        MYLOG("TCP %s:%d %s connect failed: %d", host.c_str(), port, (dest.sa_family == AF_INET6) ? "IPv6" : "IPv4",
+              errno);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int tcpSocketStrategy::raceConnect(const struct sockaddr* dest, const socklen_t* destlen, int count, int& winner)
+{
+    struct pollfd fds[dnsCache::MAX_CANDIDATES];
+    int           started    = 0;
+    int           alive      = 0;
+    int           fd         = -1;
+    int64_t       deadline   = k_uptime_get() + CONNECT_TIMEOUT_MS;
+    int64_t       next_start = 0;
+
+    while (fd < 0)
+    {
+        int64_t now = k_uptime_get();
+
+        /* Start the next family once the previous one failed or stalled past the attempt delay */
+        if ((started < count) && ((alive == 0) || (now >= next_start)))
+        {
+            fds[started].fd      = startConnect(dest[started], destlen[started]);
+            fds[started].events  = POLLOUT;
+            fds[started].revents = 0;
+            if (fds[started].fd >= 0)
+            {
+                alive++;
+            }
+            started++;
+            next_start = now + CONNECTION_ATTEMPT_DELAY_MS;
+            continue;
+        }
+
+        if ((alive == 0) || (now >= deadline))
+        {
+            break;
+        }
+
+        int64_t wait = deadline - now;
+        if (started < count)
+        {
+            wait = MIN(wait, next_start - now);
+        }
+
+        if (poll(fds, started, (int)wait) < 0)
+        {
+            break;
+        }
+
+        for (int i = 0; (i < started) && (fd < 0); i++)
+        {
+            if ((fds[i].fd < 0) || (fds[i].revents == 0))
+            {
+                continue;
+            }
+
+            int       err    = 0;
+            socklen_t errlen = sizeof(err);
+            getsockopt(fds[i].fd, SOL_SOCKET, SO_ERROR, &err, &errlen);
+
+            if ((err == 0) && !(fds[i].revents & (POLLERR | POLLHUP | POLLNVAL)))
+            {
+                fd        = fds[i].fd;
+                fds[i].fd = -1;
+                winner    = i;
+            }
+            else
+            {
+                close(fds[i].fd);
+                fds[i].fd = -1;
+                alive--;
+            }
+        }
+    }
+
+    /* The loser, or every attempt on timeout */
+    for (int i = 0; i < started; i++)
+    {
+        if (fds[i].fd >= 0)
+        {
+            close(fds[i].fd);
+        }
+    }
+
+    if (fd >= 0)
+    {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) & ~O_NONBLOCK);
+    }
+    return fd;
+}
+
+void tcpSocketStrategy::closeSocket()
 {
     if (sock >= 0)
     {
         close(sock);
         sock = -1;
+        fdChanged();
+    }
+}
+
+void tcpSocketStrategy::handleLinkLoss(int err)
+{
+    MYLOG("TCP %s:%d lost (%d), reconnecting", host.c_str(), port, err);
+    closeSocket();
+    scheduleService(nextBackoff());
+}
+
+void tcpSocketStrategy::scheduleService(uint32_t delay_ms)
+{
+    k_work_reschedule_for_queue(workQueue(), &service.work, K_MSEC(delay_ms));
+}
+
+uint32_t tcpSocketStrategy::nextBackoff()
+{
+    uint32_t shift = MIN(reconnect_attempts, 16U);
+    uint32_t delay = MIN(RECONNECT_BASE_MS << shift, RECONNECT_MAX_MS);
+    reconnect_attempts++;
+    return reconnectPolicy::equalJitter(delay);
+}
+
+void tcpSocketStrategy::enqueue(const struct iovec* iov, size_t count, size_t skip)
+{
+    /* sendv() checked the space for the whole record, so the stream never carries a torn record */
+    for (size_t i = 0; i < count; i++)
+    {
+        /* Skip what a partial write already sent */
+        size_t offset = MIN(skip, iov[i].iov_len);
+        skip -= offset;
+        ring_buf_put(&tx_ring, (const uint8_t*)iov[i].iov_base + offset, iov[i].iov_len - offset);
+    }
+}
+
+void tcpSocketStrategy::flush()
+{
+    k_mutex_lock(&lock, K_FOREVER);
+
+    while ((sock >= 0) && !ring_buf_is_empty(&tx_ring))
+    {
+        uint8_t* chunk;
+        uint32_t chunk_len = ring_buf_get_claim(&tx_ring, &chunk, TX_QUEUE_SIZE);
+        int      fd        = sock;
+
+        /* Producers only touch the put side, so the claimed chunk stays valid. The claim already moved the get
+         * head, so the ring looks empty: flushing keeps sendv() from writing ahead of these bytes */
+        flushing = true;
+        k_mutex_unlock(&lock);
+        ssize_t sent = ::send(fd, chunk, chunk_len, 0);
+        int     err  = errno;
+        k_mutex_lock(&lock, K_FOREVER);
+        flushing = false;
+
+        if (sent < 0)
+        {
+            ring_buf_get_finish(&tx_ring, 0);
+            if (fd == sock)
+            {
+                handleLinkLoss(err);
+            }
+            break;
+        }
+        ring_buf_get_finish(&tx_ring, sent);
+    }
+
+    k_mutex_unlock(&lock);
+}
+
+void tcpSocketStrategy::serviceHandler(struct k_work* work)
+{
+    struct k_work_delayable* dwork = k_work_delayable_from_work(work);
+    serviceWork*             item  = CONTAINER_OF(dwork, serviceWork, work);
+    tcpSocketStrategy*       self  = item->owner;
+
+    k_mutex_lock(&self->lock, K_FOREVER);
+    bool active    = self->is_active;
+    bool connected = (self->sock >= 0);
+    k_mutex_unlock(&self->lock);
+
+    if (!active)
+    {
+        return;
     }
+
+    if (!connected && !self->tryConnect())
+    {
+        k_mutex_lock(&self->lock, K_FOREVER);
+        if (self->is_active)
+        {
+            self->scheduleService(self->nextBackoff());
+        }
+        k_mutex_unlock(&self->lock);
+        return;
+    }
+
+    self->flush();
 }
 
 // ================= UDP =================
-bool udpSocketStrategy::connect(const std::string& host, uint16_t port)
+udpSocketStrategy::udpSocketStrategy()
 {
-    dest.sin_family = AF_INET;
-    dest.sin_port = htons(port);
-    inet_pton(AF_INET, host.c_str(), &dest.sin_addr);
+    k_mutex_init(&lock);
+}
 
-    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-    return sock >= 0;
+udpSocketStrategy::~udpSocketStrategy()
+{
+    disconnect();
+}
+
+bool udpSocketStrategy::connect(const std::string& _host, uint16_t _port)
+{
+    if (_host.empty())
+    {
+        return false;
+    }
+
+    k_mutex_lock(&lock, K_FOREVER);
+    host = _host;
+    port = _port;
+
+    /* Resolve now if cached, otherwise the first send() picks it up */
+    sa_family_t family = AF_INET;
+    if (dnsCache::getInstance().lookup(host, port, dest, destlen) == 0)
+    {
+        family = dest.sa_family;
+    }
+
+    bool ret = ensureSocket(family);
+    k_mutex_unlock(&lock);
+    return ret;
 }
 
 ssize_t udpSocketStrategy::send(const void* data, size_t len)
 {
-    return sendto(sock, data, len, 0, (struct sockaddr*)&dest, sizeof(dest));
+    struct iovec iov = {const_cast<void*>(data), len};
+    return sendv(&iov, 1);
+}
+
+ssize_t udpSocketStrategy::sendv(const struct iovec* iov, size_t count)
+{
+    /* Datagrams are short: senders take turns rather than racing on the destination and the socket */
+    k_mutex_lock(&lock, K_FOREVER);
+
+    /* Cache lookups are cheap and let UDP follow DNS changes */
+    if (dnsCache::getInstance().lookup(host, port, dest, destlen) < 0)
+    {
+        k_mutex_unlock(&lock);
+        errno = EAGAIN;
+        return -1;
+    }
+
+    if (!ensureSocket(dest.sa_family))
+    {
+        k_mutex_unlock(&lock);
+        return -1;
+    }
+
+    /* One datagram, gathered by the stack */
+    struct msghdr msg = {};
+    msg.msg_name      = &dest;
+    msg.msg_namelen   = destlen;
+    msg.msg_iov       = const_cast<struct iovec*>(iov);
+    msg.msg_iovlen    = count;
+
+    ssize_t ret = sendmsg(sock, &msg, 0);
+    int     err = errno;
+    k_mutex_unlock(&lock);
+
+    errno = err;
+    return ret;
+}
+
+bool udpSocketStrategy::ensureSocket(sa_family_t family)
+{
+    /* Called with lock held */
+    if ((sock >= 0) && (sock_family == family))
+    {
+        return true;
+    }
+
+    if (sock >= 0)
+    {
+        close(sock);
+    }
+
+    sock        = socket(family, SOCK_DGRAM, IPPROTO_UDP);
+    sock_family = family;
+    fdChanged();
+    return sock >= 0;
 }
 
 ssize_t udpSocketStrategy::receive(void* buffer, size_t maxLen)
 {
-    struct sockaddr_in src = {};
+    struct sockaddr src = {};
     socklen_t addrlen = sizeof(src);
-    return recvfrom(sock, buffer, maxLen, 0, (struct sockaddr*)&src, &addrlen);
+
+    /* Never waits, and a concurrent send cannot swap the socket underneath */
+    k_mutex_lock(&lock, K_FOREVER);
+    ssize_t ret = recvfrom(sock, buffer, maxLen, MSG_DONTWAIT, &src, &addrlen);
+    int     err = errno;
+    k_mutex_unlock(&lock);
+
+    errno = err;
+    return ret;
+}
+
+int udpSocketStrategy::getFd() const
+{
+    k_mutex_lock(&lock, K_FOREVER);
+    int fd = sock;
+    k_mutex_unlock(&lock);
+    return fd;
 }
 
 void udpSocketStrategy::disconnect()
 {
+    k_mutex_lock(&lock, K_FOREVER);
     if (sock >= 0)
     {
         close(sock);
         sock = -1;
+        fdChanged();
     }
+    k_mutex_unlock(&lock);
 }
 
 // ================= TLS =================
-bool tlsSocketStrategy::connect(const std::string& host, uint16_t port)
-{
-    struct sockaddr_in addr = {};
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
-    inet_pton(AF_INET, host.c_str(), &addr.sin_addr);
+#if defined(CONFIG_APP_TLS_CA_CERT)
+static const unsigned char tls_ca_cert[] = {
+#include "tls_ca_cert.der.inc"
+};
+#endif
 
-    sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TLS_1_2);
-    if (sock < 0)
-        return false;
+tlsSocketStrategy::tlsSocketStrategy()
+{
+    registerCredentials();
+}
 
-    return ::connect(sock, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+tlsSocketStrategy::~tlsSocketStrategy()
+{
+    /* Stop the reconnect work before the TLS overrides go away */
+    disconnect();
 }
 
-ssize_t tlsSocketStrategy::send(const void* data, size_t len)
+bool tlsSocketStrategy::registerCredentials()
 {
-    return ::send(sock, data, len, 0);
+#if defined(CONFIG_APP_TLS_CA_CERT)
+    static atomic_t registered = ATOMIC_INIT(0);
+
+    if (!atomic_cas(&registered, 0, 1))
+    {
+        return true;
+    }
+
+    int ret = tls_credential_add(CONFIG_APP_TLS_SEC_TAG, TLS_CREDENTIAL_CA_CERTIFICATE, tls_ca_cert,
+                                 sizeof(tls_ca_cert));
+    if ((ret < 0) && (ret != -EEXIST))
+    {
+        MYLOG("Failed to register TLS CA certificate: %d", ret);
+        atomic_set(&registered, 0);
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
 }
 
-ssize_t tlsSocketStrategy::receive(void* buffer, size_t maxLen)
+int tlsSocketStrategy::openSocket(sa_family_t family)
 {
-    return ::recv(sock, buffer, maxLen, 0);
+    int fd = socket(family, SOCK_STREAM, IPPROTO_TLS_1_2);
+    if (fd < 0)
+    {
+        return fd;
+    }
+
+    enableKeepalive(fd);
+
+    if (registerCredentials())
+    {
+        sec_tag_t sec_tags[] = {CONFIG_APP_TLS_SEC_TAG};
+        setsockopt(fd, SOL_TLS, TLS_SEC_TAG_LIST, sec_tags, sizeof(sec_tags));
+    }
+    else
+    {
+#if defined(CONFIG_APP_TLS_INSECURE)
+        /* Explicit opt-in: encrypt only, e.g. for a local test server */
+        MYLOG("⚠️ TLS to %s without server verification (CONFIG_APP_TLS_INSECURE)", host.c_str());
+        int verify = TLS_PEER_VERIFY_NONE;
+        setsockopt(fd, SOL_TLS, TLS_PEER_VERIFY, &verify, sizeof(verify));
+#else
+        /* Never fall back to an unverified channel */
+        MYLOG("❌ TLS to %s refused: no CA certificate (CONFIG_APP_TLS_CA_CERT)", host.c_str());
+        close(fd);
+        errno = EACCES;
+        return -1;
+#endif
+    }
+
+    setsockopt(fd, SOL_TLS, TLS_HOSTNAME, host.c_str(), host.length() + 1);
+
+    /* Cached sessions are keyed by peer address and survive closing the socket */
+    int cache = TLS_SESSION_CACHE_ENABLED;
+    if (setsockopt(fd, SOL_TLS, TLS_SESSION_CACHE, &cache, sizeof(cache)) < 0)
+    {
+        MYLOG("TLS session cache unavailable: %d", errno);
+    }
+
+    return fd;
 }
 
-void tlsSocketStrategy::disconnect()
+void tlsSocketStrategy::onConnectAttempt(bool success, int64_t elapsed_ms)
 {
-    if (sock >= 0)
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+    if (!success)
     {
-        close(sock);
-        sock = -1;
+        stats.failures++;
+        k_spin_unlock(&stats_lock, key);
+        return;
     }
+
+    uint32_t ms = (uint32_t)elapsed_ms;
+
+    if (stats.count == 0)
+    {
+        stats.first_ms = ms;
+        stats.min_ms   = ms;
+    }
+    stats.count++;
+    stats.last_ms = ms;
+    stats.min_ms  = MIN(stats.min_ms, ms);
+    stats.max_ms  = MAX(stats.max_ms, ms);
+    stats.total_ms += ms;
+
+    handshakeStats snapshot = stats;
+    k_spin_unlock(&stats_lock, key);
+
+    MYLOG("TLS handshake %u took %ums (first %ums, avg %llums)", snapshot.count, ms, snapshot.first_ms,
+          snapshot.total_ms / snapshot.count);
+}
+
+tlsSocketStrategy::handshakeStats tlsSocketStrategy::getHandshakeStats() const
+{
+    k_spinlock_key_t key      = k_spin_lock(&stats_lock);
+    handshakeStats   snapshot = stats;
+    k_spin_unlock(&stats_lock, key);
+
+    return snapshot;
 }
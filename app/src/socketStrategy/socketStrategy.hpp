@@ -19,7 +19,9 @@
 
 #pragma once
 
+#include <zephyr/kernel.h>
 #include <zephyr/net/socket.h>
+#include <zephyr/sys/ring_buffer.h>
 #include <string>
 
 class socketStrategy
@@ -27,44 +29,280 @@ class socketStrategy
 public:
     virtual bool connect(const std::string& host, uint16_t port) = 0;
     virtual ssize_t send(const void* data, size_t len) = 0;
+
+    /**
+     * @brief Send one record gathered from several buffers, without concatenating them.
+     * @param iov Buffers making up the record, sent in order.
+     * @param count Number of buffers.
+     * @return Total number of bytes sent or queued, -1 on error.
+     */
+    virtual ssize_t sendv(const struct iovec* iov, size_t count) = 0;
     virtual ssize_t receive(void* buffer, size_t maxLen) = 0;
     virtual void disconnect() = 0;
+
+    /**
+     * @brief Descriptor to poll for incoming data, or -1 while not connected.
+     */
+    virtual int getFd() const = 0;
+
+    /**
+     * @brief Number of times the connection was re-established, 0 for connectionless strategies.
+     */
+    virtual uint32_t getReconnects() const
+    {
+        return 0;
+    }
+
+    /**
+     * @brief Render counters specific to the strategy as one line of text, e.g. MQTT publish and ack counts.
+     * @note Called with the socketManager lock held, so it must not block.
+     * @return Number of characters written, 0 if the strategy has none.
+     */
+    virtual size_t formatStats(char* buffer, size_t len) const
+    {
+        ARG_UNUSED(buffer);
+        ARG_UNUSED(len);
+        return 0;
+    }
+
     virtual ~socketStrategy() = default;
+
+    /**
+     * @brief Total number of bytes described by an iovec array.
+     */
+    static size_t totalLength(const struct iovec* iov, size_t count);
+
+    /**
+     * @brief Callback for a change of any strategy's getFd().
+     */
+    using fdChangedHandler = void (*)(void* ctx);
+
+    /**
+     * @brief Register the poller to wake when a descriptor appears, goes away or is unparked.
+     * @note One handler for all strategies: the socketManager network thread, which polls without a timeout.
+     */
+    static void setFdChangedHandler(fdChangedHandler handler, void* ctx);
+
+protected:
+    /**
+     * @brief Tell the poller that getFd() now returns a different descriptor.
+     */
+    static void fdChanged();
+
+    /**
+     * @brief Shared work queue for background connects and flushes.
+     * @note Started at boot (POST_KERNEL), kept off the system work queue because connects block.
+     */
+    static struct k_work_q* workQueue();
 };
 
+/**
+ * @brief Persistent TCP strategy.
+ * @note The connection is kept alive with TCP keepalive and re-established in the
+ *       background with exponential backoff and jitter. Records sent while the link
+ *       is down are held in a bounded queue and flushed once it is back.
+ *       Dual-stack hosts are connected happy-eyeballs style: IPv6 and IPv4
+ *       attempts are staggered and raced, and the winning family is cached.
+ */
 class tcpSocketStrategy : public socketStrategy
 {
-private:
-    int sock = -1;
-
 public:
+    tcpSocketStrategy();
+    ~tcpSocketStrategy() override;
+
+    /**
+     * @brief Start the connection to the given host and port in the background.
+     * @note Never blocks: the connect runs on the socket work queue.
+     * @return true once the connect is scheduled, false if the host is empty.
+     */
     bool connect(const std::string& host, uint16_t port) override;
+
+    /**
+     * @brief Send a record, queueing it if the link is down or busy.
+     * @note Nothing is written unless the queue could take the whole record, so
+     *       the remainder of a partial write is always queued.
+     * @return len on success (sent, partly sent and queued, or queued), -1 with
+     *         errno set to ENOBUFS if the queue has no room for the whole record.
+     */
     ssize_t send(const void* data, size_t len) override;
+    ssize_t sendv(const struct iovec* iov, size_t count) override;
     ssize_t receive(void* buffer, size_t maxLen) override;
     void disconnect() override;
+    int getFd() const override;
+    uint32_t getReconnects() const override;
+
+    /**
+     * @brief Check if the TCP connection is currently established.
+     */
+    bool isConnected() const;
+
+protected:
+    /**
+     * @brief Create and configure the stream socket used by the next connect.
+     * @param family Address family of the resolved peer.
+     * @return Socket descriptor, or negative on failure.
+     */
+    virtual int openSocket(sa_family_t family);
+
+    /**
+     * @brief Called after each connect attempt with its duration.
+     * @param success true if the connection was established.
+     * @param elapsed_ms Time spent in connect(), including any handshake.
+     */
+    virtual void onConnectAttempt(bool success, int64_t elapsed_ms);
+
+    /**
+     * @brief Set keepalive options on a freshly created socket.
+     */
+    void enableKeepalive(int fd);
+
+    /**
+     * @brief Host the strategy is connecting to.
+     */
+    std::string host;
+
+private:
+    /**
+     * @brief Size of the outgoing queue used while disconnected.
+     */
+    static constexpr size_t TX_QUEUE_SIZE = 2048;
+
+    /**
+     * @brief First reconnect delay in milliseconds.
+     */
+    static constexpr uint32_t RECONNECT_BASE_MS = 500;
+
+    /**
+     * @brief Upper bound of the reconnect delay in milliseconds.
+     */
+    static constexpr uint32_t RECONNECT_MAX_MS = 30000;
+
+    /**
+     * @brief Head start given to the preferred address family before racing the other one.
+     * @note 250 ms is the Connection Attempt Delay recommended by RFC 8305.
+     */
+    static constexpr int64_t CONNECTION_ATTEMPT_DELAY_MS = 250;
+
+    /**
+     * @brief Time allowed for one (possibly raced) connect before it counts as failed.
+     */
+    static constexpr int64_t CONNECT_TIMEOUT_MS = 10000;
+
+    /**
+     * @brief Keepalive idle time, probe interval (seconds) and probe count.
+     */
+    static constexpr int KEEPALIVE_IDLE_S  = 10;
+    static constexpr int KEEPALIVE_INTVL_S = 5;
+    static constexpr int KEEPALIVE_CNT     = 3;
+
+    /**
+     * @brief Work item wrapper so the handler can find its strategy.
+     */
+    struct serviceWork
+    {
+        struct k_work_delayable work;
+        tcpSocketStrategy*      owner;
+    };
+
+    mutable struct k_mutex lock;
+    int                    sock = -1;
+    bool                   is_active = false;
+    bool                   flushing = false;
+    uint16_t               port = 0;
+    uint32_t               reconnect_attempts = 0;
+    uint32_t               connects = 0;
+    uint32_t               dropped_records = 0;
+    serviceWork            service;
+    struct ring_buf        tx_ring;
+    uint8_t                tx_storage[TX_QUEUE_SIZE];
+
+    bool     tryConnect();
+    int      startConnect(const struct sockaddr& dest, socklen_t destlen);
+    int      raceConnect(const struct sockaddr* dest, const socklen_t* destlen, int count, int& winner);
+    void     closeSocket();
+    void     handleLinkLoss(int err);
+    void     scheduleService(uint32_t delay_ms);
+    uint32_t nextBackoff();
+    void     enqueue(const struct iovec* iov, size_t count, size_t skip);
+    void     flush();
+
+    static void serviceHandler(struct k_work* work);
 };
 
+/**
+ * @brief Connectionless UDP strategy.
+ * @note Sends may come from several threads at once and the network thread receives meanwhile: lock guards the
+ *       socket and the destination, which follow DNS changes.
+ */
 class udpSocketStrategy : public socketStrategy
 {
 private:
+    mutable struct k_mutex lock;
     int sock = -1;
-    struct sockaddr_in dest = {};
+    sa_family_t sock_family = AF_UNSPEC;
+    std::string host;
+    uint16_t port = 0;
+    struct sockaddr dest = {};
+    socklen_t destlen = 0;
+
+    bool ensureSocket(sa_family_t family);
 
 public:
+    udpSocketStrategy();
+    ~udpSocketStrategy() override;
+
     bool connect(const std::string& host, uint16_t port) override;
     ssize_t send(const void* data, size_t len) override;
+    ssize_t sendv(const struct iovec* iov, size_t count) override;
     ssize_t receive(void* buffer, size_t maxLen) override;
     void disconnect() override;
+    int getFd() const override;
 };
 
-class tlsSocketStrategy : public socketStrategy
+/**
+ * @brief TLS 1.2 strategy built on the persistent TCP strategy.
+ * @note Credentials are registered once through the TLS credential API and the
+ *       session cache is enabled, so reconnects resume the previous session
+ *       instead of paying for a full handshake. Without a CA certificate no
+ *       connection is made, unless CONFIG_APP_TLS_INSECURE opts out of
+ *       server verification.
+ */
+class tlsSocketStrategy : public tcpSocketStrategy
 {
+public:
+    /**
+     * @brief Handshake timing statistics.
+     */
+    struct handshakeStats
+    {
+        uint32_t count;    /**< Successful handshakes */
+        uint32_t failures; /**< Failed connect/handshake attempts */
+        uint32_t first_ms; /**< Duration of the first (full) handshake */
+        uint32_t last_ms;  /**< Duration of the latest handshake */
+        uint32_t min_ms;   /**< Fastest handshake */
+        uint32_t max_ms;   /**< Slowest handshake */
+        uint64_t total_ms; /**< Sum of all handshake durations */
+    };
+
+    tlsSocketStrategy();
+    ~tlsSocketStrategy() override;
+
+    /**
+     * @brief Get a snapshot of the handshake statistics.
+     */
+    handshakeStats getHandshakeStats() const;
+
+protected:
+    int  openSocket(sa_family_t family) override;
+    void onConnectAttempt(bool success, int64_t elapsed_ms) override;
+
 private:
-    int sock = -1;
+    mutable struct k_spinlock stats_lock = {}; /**< Stats are written by the connect work, read by any thread */
+    handshakeStats            stats      = {};
 
-public:
-    bool connect(const std::string& host, uint16_t port) override;
-    ssize_t send(const void* data, size_t len) override;
-    ssize_t receive(void* buffer, size_t maxLen) override;
-    void disconnect() override;
+    /**
+     * @brief Register the CA certificate with the TLS credential store once.
+     * @return true if the credential is available under the sec tag.
+     */
+    static bool registerCredentials();
 };
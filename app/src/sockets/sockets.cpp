@@ -25,6 +25,7 @@ sockets::sockets()
     host = "0";
     port = 0;
     proto = socketManager::protocol::UDP;
+    isOpen = false;
 }
 
 sockets::~sockets()
@@ -34,19 +35,47 @@ sockets::~sockets()
 
 bool sockets::open(std::string server, uint16_t _port, socketManager::protocol protocol)
 {
+    /* Reopening releases the previous socket first */
+    close();
+
     /* Save the parameters */
     host = server;
     port = _port;
     proto = protocol;
-    return pSocketManager->open(proto, host, port);
+    isOpen = pSocketManager->open(proto, host, port);
+    return isOpen;
 }
 
 void sockets::close()
 {
-
+    if (isOpen)
+    {
+        pSocketManager->close(proto, host, port);
+        isOpen = false;
+    }
 }
 
-uint32_t sockets::send(const char* data, size_t len)
+ssize_t sockets::send(const char* data, size_t len)
 {
     return pSocketManager->send(host, proto, port, data, len);
 }
+
+ssize_t sockets::send(const struct iovec* iov, size_t count)
+{
+    return pSocketManager->send(host, proto, port, iov, count);
+}
+
+ssize_t sockets::receive(char* buffer, size_t maxLen)
+{
+    return pSocketManager->receive(host, proto, port, buffer, maxLen);
+}
+
+bool sockets::onReceive(socketManager::rxHandler handler, void* ctx)
+{
+    return pSocketManager->setReceiveHandler(host, proto, port, handler, ctx);
+}
+
+bool sockets::setAsync(socketManager::overflowPolicy policy, uint32_t timeout_ms)
+{
+    return pSocketManager->setAsync(host, proto, port, policy, timeout_ms);
+}
@@ -51,7 +51,7 @@ public:
 
     /**
      * @brief Close the socket connection.
-     * @note Removes socket from the socketManager registry.
+     * @note Releases this wrapper's reference, the last user of a shared socket disconnects it.
      */
     void close();
 
@@ -60,17 +60,48 @@ public:
      *
      * @param data Pointer to data buffer to send.
      * @param len Length of the buffer in bytes.
-     * @return uint32_t Number of bytes sent or error code.
+     * @return ssize_t Number of bytes sent or queued, -1 on error (errno set).
      */
-    uint32_t send(const char* data, size_t len);
+    ssize_t send(const char* data, size_t len);
 
     /**
-     * @brief Receive data from the socket.
+     * @brief Send one record gathered from several buffers.
+     *
+     * @param iov Buffers making up the record (e.g. header, payload, trailer), sent in order.
+     * @param count Number of buffers.
+     * @return ssize_t Total number of bytes sent or queued, -1 on error.
+     * @note Saves concatenating into a temporary buffer before sending.
+     */
+    ssize_t send(const struct iovec* iov, size_t count);
+
+    /**
+     * @brief Switch the socket to async send mode.
+     *
+     * @param policy What to do when the socket queue is full.
+     * @param timeout_ms Maximum wait for socketManager::overflowPolicy::BLOCK.
+     * @return true if the socket is open and switched to async mode.
+     * @note send() then only copies into the queue, the network thread does the I/O.
+     */
+    bool setAsync(socketManager::overflowPolicy policy, uint32_t timeout_ms = 0);
+
+    /**
+     * @brief Receive data from the socket without blocking.
      *
      * @param buffer Destination buffer to receive data.
      * @param maxLen Maximum number of bytes to read.
+     * @return ssize_t Number of bytes read, or -1 if nothing is pending.
+     * @note Do not mix with onReceive(), the network thread consumes the data then.
      */
-    void receive(char* buffer, size_t maxLen);
+    ssize_t receive(char* buffer, size_t maxLen);
+
+    /**
+     * @brief Register a handler called on the network thread for incoming data.
+     *
+     * @param handler Function receiving a buffer from the RX pool.
+     * @param ctx User context passed back to the handler.
+     * @return true if the socket is open and the handler was registered.
+     */
+    bool onReceive(socketManager::rxHandler handler, void* ctx);
 
 private:
     /**
@@ -92,4 +123,9 @@ private:
      * @brief Port number used by the socket.
      */
     uint16_t port;
+
+    /**
+     * @brief Whether this wrapper holds a socketManager reference.
+     */
+    bool isOpen;
 };
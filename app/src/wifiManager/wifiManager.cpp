@@ -21,6 +21,7 @@
 #include "myLogger.hpp"
 
 #include <zephyr/net/wifi_mgmt.h>
+#include <zephyr/shell/shell.h>
 /* Anonymous namespace limits the visibility of `registered` to this file only,
    preventing linker conflicts with other translation units.
 */
@@ -66,9 +67,14 @@ bool registered = []
 wifiManager* wifiManager::instance_ptr;
 
 wifiManager::wifiManager()
-    : isConnecting(false), isError(false), isIpObtained(false), isScanComplete(false), state(IDLE), iface(nullptr)
+    : isConnecting(false), isError(false), isIpObtained(false), isScanComplete(false), state(IDLE), iface(nullptr),
+      status_cache{}, status_refreshed_at(0), stats{}
 {
     instance_ptr = nullptr;
+    atomic_set(&status_dirty, 1);
+    atomic_set(&update_pending, 1);
+    atomic_set(&hint_failed, 0);
+    k_event_init(&status_event);
 }
 
 wifiManager& wifiManager::getInstance()
@@ -95,16 +101,32 @@ void wifiManager::register_wifi_events()
 
 void wifiManager::reinit()
 {
-    struct wifi_iface_status status = get_wifi_status(iface);
+    int64_t end = k_uptime_get() + REINIT_TIMEOUT_MS;
+
+    refresh_status();
 
-    while (status.state != WIFI_STATE_COMPLETED)
+    /* Wait for Wifi to be in known state */
+    while (true)
     {
-        if ((status.state == WIFI_STATE_INACTIVE) || (status.state == WIFI_STATE_DISCONNECTED))
+        int state_now = getStatus().state;
+        if ((state_now == WIFI_STATE_COMPLETED) || (state_now == WIFI_STATE_INACTIVE) ||
+            (state_now == WIFI_STATE_DISCONNECTED))
+        {
+            break;
+        }
+
+        int64_t left = end - k_uptime_get();
+        if (left <= 0)
         {
+            MYLOG("Wi-Fi did not settle, state: %s", wifi_state_txt(static_cast<wifi_iface_state>(state_now)));
             break;
         }
-        /* Wait for Wifi to be in known state */
-        status = get_wifi_status(iface);
+
+        if (k_event_wait(&status_event, STATUS_CHANGED, false, K_MSEC(MIN(left, REINIT_POLL_MS))) != 0)
+        {
+            k_event_clear(&status_event, STATUS_CHANGED);
+        }
+        refresh_status();
     }
 
     // struct wifi_connect_req_params params =
@@ -133,16 +155,6 @@ bool wifiManager::init()
 
     /* Initialization logic here */
 
-    /* State Machine Initialization */
-    idle         = new wifiStateIdle(nullptr);
-    disconnected = new wifiStateDisconnected(idle);
-    connected    = new wifiStateConnected(disconnected);
-    connecting   = new wifiStateConnecting(connected);
-
-    /* Connect the loop back */
-    *idle = wifiStateIdle(connecting);
-    error = new wifiStateError(idle, disconnected);
-
     /* Get the WiFi Interface */
     // for (struct net_if* it = net_if_get_first(); it != NULL; it = net_if_get_next(it))
     // {
@@ -156,7 +168,7 @@ bool wifiManager::init()
     iface = net_if_get_first_wifi();
 
     /* StateMachine Context */
-    context = new wifiContext(idle, iface);
+    context.start(iface);
 
     /* Register the WiFi Event Handlers */
     register_wifi_events();
@@ -195,8 +207,8 @@ bool wifiManager::init()
     }
     else
     {
-        state = ERROR;
-        context->setState(static_cast<wifiState*>(error));
+        context.dispatch(wifiEvent::FAULT);
+        state = context.getState();
     }
 
     return true;
@@ -204,52 +216,168 @@ bool wifiManager::init()
 
 void wifiManager::tick()
 {
-    struct wifi_iface_status status = {0};
+    bool transition = (state == CONNECTING) || context.hasPosted();
+    bool changed    = false;
 
-    status = get_wifi_status(iface);
+    /* Read the driver only after an event, while a transition is pending, or for a slow RSSI refresh */
+    if (atomic_cas(&status_dirty, 1, 0) || transition || (k_uptime_get() - status_refreshed_at >= STATUS_REFRESH_MS))
+    {
+        changed = refresh_status();
+    }
 
-    if (context)
+    /* A hinted attempt failed: the AP moved or went away, scan for it instead */
+    if (atomic_cas(&hint_failed, 1, 0) && (state == CONNECTING))
     {
-        context->update(status);
-        state = context->getState();
+        MYLOG("⚡ Hinted connect failed, retrying with a full scan");
+        context.attempt().clearHints();
+        countFallback();
+        context.dispatch(wifiEvent::RETRY);
+    }
+
+    /* The state machine runs only on a change */
+    if (changed || atomic_cas(&update_pending, 1, 0))
+    {
+        wifiStateEnum previous = state;
+
+        context.update(getStatus());
+        state = context.getState();
+
+        if (state != previous)
+        {
+            /* One step per update: let the new state handle the same status */
+            atomic_set(&update_pending, 1);
+
+            if ((previous == CONNECTING) && (state == CONNECTED))
+            {
+                onConnected();
+            }
+        }
     }
 }
 
-void wifiManager::connect()
+void wifiManager::onConnected()
 {
-    if (!isError && (IDLE == state))
+    wifiConnectAttempt::connectTiming timing = context.attempt().getTiming();
+
+    /* Read the AP the driver picked and keep it for the next reconnect */
+    refresh_status();
+    context.attempt().setHints(getStatus());
+
+    k_spinlock_key_t key = k_spin_lock(&status_lock);
+    stats.attempts++;
+    stats.last_associated_ms = timing.associated_ms;
+    stats.last_ip_ms         = timing.ip_ms;
+    if (timing.hinted)
     {
-        MYLOG("🔗 Connecting to Wi-Fi");
-        idle->setConnectingCalled(true);
+        stats.hinted++;
+        stats.hinted_ip_ms_sum += timing.ip_ms;
     }
-    else if (DISCONNECTED == state)
+    else
+    {
+        stats.full_ip_ms_sum += timing.ip_ms;
+    }
+    k_spin_unlock(&status_lock, key);
+
+    MYLOG("⏱️ Wi-Fi %s connect: associated in %u ms, IP in %u ms", timing.hinted ? "hinted" : "full scan",
+          timing.associated_ms, timing.ip_ms);
+}
+
+wifiManager::connectStats wifiManager::getConnectStats()
+{
+    k_spinlock_key_t key      = k_spin_lock(&status_lock);
+    connectStats     snapshot = stats;
+    k_spin_unlock(&status_lock, key);
+
+    return snapshot;
+}
+
+void wifiManager::countFallback()
+{
+    k_spinlock_key_t key = k_spin_lock(&status_lock);
+    stats.fallbacks++;
+    k_spin_unlock(&status_lock, key);
+}
+
+size_t wifiManager::getTransitionTrace(wifiContext::transition* out, size_t max)
+{
+    return context.getTrace(out, max);
+}
+
+bool wifiManager::refresh_status()
+{
+    struct wifi_iface_status status = get_wifi_status(iface);
+
+    k_spinlock_key_t key     = k_spin_lock(&status_lock);
+    bool             changed = (status.state != status_cache.state);
+    status_cache             = status;
+    status_refreshed_at      = k_uptime_get();
+    k_spin_unlock(&status_lock, key);
+
+    return changed;
+}
+
+void wifiManager::set_cached_state(enum wifi_iface_state wifi_state)
+{
+    k_spinlock_key_t key = k_spin_lock(&status_lock);
+    status_cache.state   = wifi_state;
+    k_spin_unlock(&status_lock, key);
+
+    /* The rest of the status (SSID, channel, RSSI) is re-read by the next tick() */
+    atomic_set(&status_dirty, 1);
+    atomic_set(&update_pending, 1);
+    k_event_post(&status_event, STATUS_CHANGED);
+}
+
+wifi_iface_status wifiManager::getStatus()
+{
+    k_spinlock_key_t  key    = k_spin_lock(&status_lock);
+    wifi_iface_status status = status_cache;
+    k_spin_unlock(&status_lock, key);
+
+    return status;
+}
+
+void wifiManager::connect()
+{
+    atomic_set(&update_pending, 1);
+
+    if (IDLE == state)
     {
-        /* If it was in Disconnect then trigger it from Disconnect State. */
-        MYLOG("🔗 Connecting to Wi-Fi Again after disconnect");
-        context->setState(static_cast<wifiState*>(connecting));
+        /* Applied by the next tick(), once the interface is inactive or disconnected */
+        MYLOG("🔗 Connecting to Wi-Fi");
+        context.post(wifiEvent::CONNECT);
     }
     else
     {
-        MYLOG("❌ Error in Wi-Fi Initialization. Cannot Connect");
-        context->setState(static_cast<wifiState*>(error));
+        /* From Disconnected: reconnect; from Error: stays there until it recovers */
+        context.dispatch(wifiEvent::CONNECT);
+        state = context.getState();
     }
 }
 
 void wifiManager::disconnect()
 {
     MYLOG("❌ Disconnecting from Wi-Fi");
+    atomic_set(&update_pending, 1);
+
+    if ((state == CONNECTING) && context.attempt().isHinted())
+    {
+        /* The hinted attempt timed out, scan on the next one */
+        context.attempt().clearHints();
+        countFallback();
+    }
 
     int ret = net_mgmt(NET_REQUEST_WIFI_DISCONNECT, iface, NULL, 0);
     if (ret)
     {
         MYLOG("WiFi Disconnection Request Failed");
-        context->setState(static_cast<wifiState*>(error));
+        context.dispatch(wifiEvent::FAULT);
     }
     else
     {
-        connected->setDisconnectCalled(true);
-        context->setState(static_cast<wifiState*>(disconnected));
+        context.dispatch(wifiEvent::DISCONNECT);
     }
+    state = context.getState();
 }
 
 void wifiManager::scan()
@@ -291,9 +419,7 @@ wifiStateEnum wifiManager::getWifiState()
 
 wifiStateEnum wifiManager::wifi_status()
 {
-    struct wifi_iface_status status = {0};
-
-    status = get_wifi_status(iface);
+    struct wifi_iface_status status = getStatus();
 
     MYLOG("Wifi Interface Status: %s", wifi_state_txt(static_cast<wifi_iface_state>(status.state)));
 
@@ -309,6 +435,20 @@ wifiStateEnum wifiManager::wifi_status()
     return state;
 }
 
+void wifiManager::setEventNotifier(struct k_event* event, uint32_t mask)
+{
+    notify_event = event;
+    notify_mask  = mask;
+}
+
+void wifiManager::notify()
+{
+    if (notify_event)
+    {
+        k_event_post(notify_event, notify_mask);
+    }
+}
+
 void wifiManager::setScanComplete(bool value)
 {
     isScanComplete = value;
@@ -318,3 +458,28 @@ const char* wifiManager::name() const
 {
     return "wifiManager";
 }
+
+#if defined(CONFIG_SHELL)
+static int cmdWifiSmTrace(const struct shell* sh, size_t argc, char** argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    wifiContext::transition trace[wifiContext::TRACE_DEPTH];
+    size_t                  count = wifiManager::getInstance().getTransitionTrace(trace, ARRAY_SIZE(trace));
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const wifiContext::transition& t = trace[i];
+
+        shell_print(sh, "%10u ms  %-12s -> %-12s on %-10s %6u us", t.at_ms, wifiContext::stateName(t.from),
+                    wifiContext::stateName(t.to), wifiContext::eventName(t.event), t.latency_us);
+    }
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_wifi_sm,
+                               SHELL_CMD(trace, NULL, "Recent state transitions, newest first", cmdWifiSmTrace),
+                               SHELL_SUBCMD_SET_END);
+SHELL_CMD_REGISTER(wifi_sm, &sub_wifi_sm, "Wi-Fi state machine", NULL);
+#endif
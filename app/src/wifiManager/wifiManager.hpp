@@ -21,8 +21,6 @@
 
 /* State Machine inlcudes */
 #include "wifiContext.hpp"
-#include "wifiStateImp.hpp"
-#include "wifiManager.hpp"
 
 /* Zephyr APIs */
 #include <zephyr/net/net_if.h>
@@ -31,6 +29,21 @@
 
 class wifiManager : public iManager
 {
+  public:
+    /**
+     * @brief Connect attempt counters and the timing of the last successful attempt.
+     */
+    struct connectStats
+    {
+        uint32_t attempts;           /**< Connect requests that reached Connected */
+        uint32_t hinted;             /**< Of those, connected with the BSSID/channel hints */
+        uint32_t fallbacks;          /**< Hinted attempts that failed and fell back to a full scan */
+        uint32_t last_associated_ms; /**< Request to association, last attempt */
+        uint32_t last_ip_ms;         /**< Request to IPv4 address, last attempt */
+        uint32_t hinted_ip_ms_sum;   /**< Sum of time-to-IP over hinted attempts */
+        uint32_t full_ip_ms_sum;     /**< Sum of time-to-IP over full-scan attempts */
+    };
+
   private:
     /* Declaration of the static Singleton */
     static wifiManager* instance_ptr;
@@ -42,17 +55,57 @@ class wifiManager : public iManager
 
     wifiStateEnum state;
 
-    wifiContext*           context;
-    wifiStateIdle*         idle;
-    wifiStateDisconnected* disconnected;
-    wifiStateConnected*    connected;
-    wifiStateConnecting*   connecting;
-    wifiStateError*        error;
+    /* State machine, statically allocated with the manager */
+    wifiContext context;
 
     struct net_if*                 iface;
     struct net_mgmt_event_callback wifi_cb;
     struct net_mgmt_event_callback ipv4_cb;
 
+    /* Owner's event object, posted after every Wi-Fi/IPv4 event is handled */
+    struct k_event* notify_event = nullptr;
+    uint32_t        notify_mask  = 0;
+
+    /**
+     * @brief Interface status cached from the event handlers instead of queried every tick.
+     * @note The handlers update the state field and mark it dirty; tick() then reads the
+     *       full status (SSID, channel, RSSI) from the driver once.
+     */
+    struct k_spinlock        status_lock;
+    struct wifi_iface_status status_cache;
+    int64_t                  status_refreshed_at;
+    atomic_t                 status_dirty;
+
+    /* State machine needs another update: request made or state changed */
+    atomic_t update_pending;
+
+    /* A hinted connect failed, retry with a full scan */
+    atomic_t hint_failed;
+
+    /* Written on the manager thread, read by getConnectStats(): guarded by status_lock */
+    connectStats stats;
+
+    /* Posted by the handlers, reinit() waits on it */
+    struct k_event status_event;
+
+    /**
+     * @brief Period of the status refresh without events, for RSSI
+     */
+    static constexpr uint32_t STATUS_REFRESH_MS = 30000;
+
+    /**
+     * @brief Longest reinit() waits for the interface to settle
+     */
+    static constexpr uint32_t REINIT_TIMEOUT_MS = 10000;
+
+    /**
+     * @brief Status re-read period while reinit() waits
+     * @note Not every driver state change raises an event.
+     */
+    static constexpr uint32_t REINIT_POLL_MS = 500;
+
+    static constexpr uint32_t STATUS_CHANGED = BIT(0);
+
     void register_wifi_events();
 
     /* Handlers */
@@ -70,6 +123,15 @@ class wifiManager : public iManager
     static void wifi_mgmt_event_handler(struct net_mgmt_event_callback* cb, uint32_t mgmt_event, struct net_if* iface);
 
     void setScanComplete(bool);
+    void notify();
+
+    /* Fast reconnect */
+    void onConnected();
+    void countFallback();
+
+    /* Status cache */
+    bool refresh_status();
+    void set_cached_state(enum wifi_iface_state wifi_state);
 
   public:
     wifiManager();
@@ -86,5 +148,29 @@ class wifiManager : public iManager
     wifiStateEnum       wifi_status();
     wifiStateEnum       getWifiState();
     wifi_iface_status   get_wifi_status(struct net_if* iface);
+
+    /**
+     * @brief Get the cached interface status.
+     * @note No net_mgmt request: kept current by the event handlers and tick().
+     */
+    wifi_iface_status getStatus();
+
+    /**
+     * @brief Get the connect attempt counters and timings.
+     */
+    connectStats getConnectStats();
+
+    /**
+     * @brief Copy the state machine's transition trace, newest first.
+     */
+    size_t getTransitionTrace(wifiContext::transition* out, size_t max);
+
     struct net_if*      get_wifi_iface();
+
+    /**
+     * @brief Post @p mask to @p event whenever a Wi-Fi or IPv4 event has been handled.
+     * @note Lets the owner sleep instead of polling tick(); posted after the handlers
+     *       have updated the state machine, so a woken tick() sees the change.
+     */
+    void setEventNotifier(struct k_event* event, uint32_t mask);
 };
@@ -74,7 +74,8 @@ void wifiManager::handle_wifi_disconnect_result(struct net_mgmt_event_callback *
         {
             MYLOG("[Disconnect Handler] ❌ Wifi Disconnected without Disconnect being called Before");
             MYLOG("[Disconnect Handler] Reason: Disconnection request (%d)", status->disconn_reason);
-            getInstance().context->setState(static_cast<wifiState *>(getInstance().error));
+            getInstance().context.post(wifiEvent::LINK_LOST);
+            atomic_set(&getInstance().update_pending, 1);
         }
     }
     else
@@ -113,9 +114,11 @@ void wifiManager::handle_ipv4_result(struct net_if *iface)
                                 &iface->config.ip.ipv4->gw,
                                 buf, sizeof(buf)));
 
-        connecting->setIsConnected(true);
+        context.attempt().setIpObtained();
     }
 
+    /* An address changes no Wi-Fi state, but Connecting waits for it */
+    atomic_set(&update_pending, 1);
     k_sem_give(&ipv4_address_obtained);
 }
 
@@ -129,7 +132,7 @@ void wifiManager::ipv4_mgmt_event_handler(struct net_mgmt_event_callback *cb,
 
     if (mgmt_event && _NET_EVENT_IPV4_BASE)
     {
-        wifiManager wifi = wifiManager::getInstance();
+        wifiManager& wifi = wifiManager::getInstance();
 
         if ((mgmt_event & (NET_EVENT_IPV4_CMD_ADDR_ADD |
                           NET_EVENT_IPV4_CMD_ADDR_DEL |
@@ -158,6 +161,8 @@ void wifiManager::ipv4_mgmt_event_handler(struct net_mgmt_event_callback *cb,
             MYLOG("[IPv4] ❌ IPv4 Multicast address removed");
         }
     }
+
+    getInstance().notify();
 }
 
 void wifiManager::wifi_mgmt_event_handler(struct net_mgmt_event_callback *cb,
@@ -173,19 +178,31 @@ void wifiManager::wifi_mgmt_event_handler(struct net_mgmt_event_callback *cb,
         MYLOG("[Legend] NET_EVENT_WIFI_SCAN_RESULT : 0x%08lX", NET_EVENT_WIFI_SCAN_RESULT);
         MYLOG("[Legend] NET_EVENT_WIFI_DISCONNECT_RESULT : 0x%08lX", NET_EVENT_WIFI_DISCONNECT_RESULT);
 
-        wifiManager instance = wifiManager::getInstance();
+        wifiManager& instance = wifiManager::getInstance();
+        const struct wifi_status* status = (const struct wifi_status *)cb->info;
 
-        if (mgmt_event & NET_EVENT_WIFI_CMD_CONNECT_RESULT)
+        if (mgmt_event == NET_EVENT_WIFI_CONNECT_RESULT)
         {
             instance.handle_wifi_connect_result(cb);
+            instance.set_cached_state(status->status ? WIFI_STATE_DISCONNECTED : WIFI_STATE_COMPLETED);
+
+            if (status->status == 0)
+            {
+                instance.context.attempt().setAssociated();
+            }
+            else if (instance.context.attempt().isHinted())
+            {
+                atomic_set(&instance.hint_failed, 1);
+            }
         }
-        if (mgmt_event & NET_EVENT_WIFI_CMD_CONNECT_RESULT)
+        if (mgmt_event == NET_EVENT_WIFI_DISCONNECT_RESULT)
         {
             if (instance.getWifiState() == wifiStateEnum::CONNECTED)
             {
                 /* Only Call if it is in connected state already */
                 instance.handle_wifi_disconnect_result(cb);
             }
+            instance.set_cached_state(WIFI_STATE_DISCONNECTED);
         }
         // if (mgmt_event & NET_EVENT_WIFI_CMD_SCAN_RESULT)
         // {
@@ -198,5 +215,6 @@ void wifiManager::wifi_mgmt_event_handler(struct net_mgmt_event_callback *cb,
         // }
     }
 
+    getInstance().notify();
 }
 
@@ -0,0 +1,117 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2025 Osama Salah-ud-Din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <zephyr/net/net_if.h>
+#include <zephyr/net/wifi_mgmt.h>
+#include <cstring>
+
+#include "wifiConnectAttempt.hpp"
+#include "myLogger.hpp"
+
+wifiConnectAttempt::wifiConnectAttempt()
+{
+    atomic_set(&associated_at, 0);
+    atomic_set(&ip_at, 0);
+}
+
+int wifiConnectAttempt::start(struct net_if* iface)
+{
+    started_at = k_uptime_get_32();
+    atomic_set(&associated_at, 0);
+    atomic_set(&ip_at, 0);
+
+    /* Take the SSID and Password from Environment Variables. */
+    static const char ssid[]     = WIFI_SSID;
+    static const char password[] = WIFI_PASSWORD;
+
+    struct wifi_connect_req_params params =
+    {
+        .ssid = (const uint8_t*) ssid,
+        .ssid_length = (uint8_t) (sizeof(ssid) - 1),
+        .psk = (const uint8_t*) password,
+        .psk_length = (uint8_t) (sizeof(password) - 1),
+        .security = WIFI_SECURITY_TYPE_PSK,
+    };
+
+    /* Skip the full scan: go straight to the AP and channel of the last connection */
+    hinted = hints.valid;
+    if (hinted)
+    {
+        memcpy(params.bssid, hints.bssid, sizeof(params.bssid));
+        params.channel = hints.channel;
+        params.band    = hints.band;
+        MYLOG("⚡ Fast reconnect hint: BSSID %02x:%02x:%02x:%02x:%02x:%02x channel %u", hints.bssid[0],
+              hints.bssid[1], hints.bssid[2], hints.bssid[3], hints.bssid[4], hints.bssid[5], hints.channel);
+    }
+
+    int ret = net_mgmt(NET_REQUEST_WIFI_CONNECT, iface, &params, sizeof(params));
+    if (ret)
+    {
+        MYLOG("Failed to connect to WiFi network! [Error]:%d", ret);
+    }
+    else
+    {
+        MYLOG("🔗 Connecting to Wi-Fi [SSID]: %s", ssid);
+    }
+    return ret;
+}
+
+bool wifiConnectAttempt::hasIp() const
+{
+    return atomic_get(&ip_at) != 0;
+}
+
+void wifiConnectAttempt::setAssociated()
+{
+    atomic_cas(&associated_at, 0, (atomic_val_t)k_uptime_get_32());
+}
+
+void wifiConnectAttempt::setIpObtained()
+{
+    atomic_cas(&ip_at, 0, (atomic_val_t)k_uptime_get_32());
+}
+
+void wifiConnectAttempt::setHints(const wifi_iface_status& status)
+{
+    memcpy(hints.bssid, status.bssid, sizeof(hints.bssid));
+    hints.channel = status.channel;
+    hints.band    = status.band;
+    hints.valid   = true;
+}
+
+void wifiConnectAttempt::clearHints()
+{
+    hints.valid = false;
+}
+
+bool wifiConnectAttempt::isHinted() const
+{
+    return hinted;
+}
+
+wifiConnectAttempt::connectTiming wifiConnectAttempt::getTiming()
+{
+    uint32_t associated = atomic_get(&associated_at);
+    uint32_t ip         = atomic_get(&ip_at);
+
+    connectTiming timing;
+    timing.associated_ms = associated ? (associated - started_at) : 0;
+    timing.ip_ms         = ip ? (ip - started_at) : 0;
+    timing.hinted        = hinted;
+    return timing;
+}
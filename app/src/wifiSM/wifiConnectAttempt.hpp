@@ -0,0 +1,86 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2025 Osama Salah-ud-Din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/net_if.h>
+#include <zephyr/net/wifi_mgmt.h>
+#include <zephyr/sys/atomic.h>
+
+/**
+ * @brief One connect request: the BSSID/channel hints it uses and how long it takes.
+ * @note Owned by wifiContext; the Connecting entry action starts it.
+ */
+class wifiConnectAttempt
+{
+  public:
+    /**
+     * @brief Access point of the last successful connection, passed as connect hints.
+     */
+    struct connectHints
+    {
+        bool    valid = false;
+        uint8_t bssid[WIFI_MAC_ADDR_LEN];
+        uint8_t channel;
+        uint8_t band;
+    };
+
+    /**
+     * @brief Timing of the current connect attempt, in ms since it was requested.
+     * @note Written by the net_mgmt handlers, read by the main loop.
+     */
+    struct connectTiming
+    {
+        uint32_t associated_ms; /**< CONNECT_RESULT success, 0 until then */
+        uint32_t ip_ms;         /**< IPv4 address added, 0 until then */
+        bool     hinted;        /**< Attempt used the BSSID/channel hints */
+    };
+
+    wifiConnectAttempt();
+
+    /**
+     * @brief Send NET_REQUEST_WIFI_CONNECT, with the hints when there are any.
+     *
+     * @param iface Wi-Fi interface.
+     * @return 0 if the request was accepted, the net_mgmt error otherwise.
+     */
+    int start(struct net_if* iface);
+
+    /**
+     * @brief Whether the attempt reached an IPv4 address.
+     */
+    bool hasIp(void) const;
+
+    /* Called from the net_mgmt handlers */
+    void setAssociated(void);
+    void setIpObtained(void);
+
+    /* Fast reconnect */
+    void          setHints(const wifi_iface_status& status);
+    void          clearHints(void);
+    bool          isHinted(void) const;
+    connectTiming getTiming(void);
+
+  private:
+    connectHints hints;
+    bool         hinted     = false;
+    uint32_t     started_at = 0;
+    atomic_t     associated_at;
+    atomic_t     ip_at;
+};
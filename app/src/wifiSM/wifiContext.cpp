@@ -1,7 +1,7 @@
 /*
  * This file is part of the Zephyr Home project.
  *
- * Copyright (C) 2024 Osama Salah-ud-din
+ * Copyright (C) 2025 Osama Salah-ud-Din
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU Affero General Public License as published by
@@ -17,48 +17,293 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "wifiContext.hpp"
+#include "myLogger.hpp"
 
-wifiContext::wifiContext(wifiState* initial, net_if* _iface) : state(initial)
+#include <iterator>
+
+namespace
 {
-    iface = _iface;
-    state->enter(*this, iface);
+constexpr size_t EVENT_COUNT = static_cast<size_t>(wifiEvent::COUNT);
+
+enum class rule : uint8_t
+{
+    UNHANDLED = 0, /**< Left out of the table, rejected at compile time */
+    IGNORE,
+    GOTO,
+};
+
+struct cell
+{
+    rule          kind;
+    wifiStateEnum target;
+};
+
+constexpr cell go(wifiStateEnum target)
+{
+    return {rule::GOTO, target};
 }
 
-void wifiContext::setState(wifiState* newState)
+constexpr cell ignore = {rule::IGNORE, IDLE};
+
+struct row
+{
+    wifiStateEnum state;
+    cell          on[EVENT_COUNT];
+};
+
+/* clang-format off */
+/*                          CONNECT          DISCONNECT         CONNECTED       LINK_LOST   RETRY            FAULT       RECOVER */
+constexpr row table[] = {
+    {IDLE,         {go(CONNECTING),  go(DISCONNECTED),  ignore,         go(ERROR),  ignore,          go(ERROR),  ignore}},
+    {CONNECTING,   {ignore,          go(DISCONNECTED),  go(CONNECTED),  go(ERROR),  go(CONNECTING),  go(ERROR),  ignore}},
+    {CONNECTED,    {ignore,          go(DISCONNECTED),  ignore,         go(ERROR),  ignore,          go(ERROR),  ignore}},
+    {DISCONNECTED, {go(CONNECTING),  ignore,            ignore,         ignore,     ignore,          go(ERROR),  ignore}},
+    {ERROR,        {go(ERROR),       go(DISCONNECTED),  ignore,         ignore,     ignore,          ignore,     go(DISCONNECTED)}},
+};
+/* clang-format on */
+
+constexpr bool rowsInStateOrder()
 {
-    state = newState;
-    MYLOG("🔁 Transitioned to state: %s", getStateName());
-    state->enter(*this, iface);
+    for (size_t s = 0; s < std::size(table); s++)
+    {
+        if (table[s].state != static_cast<wifiStateEnum>(s))
+        {
+            return false;
+        }
+    }
+    return true;
 }
 
-void wifiContext::update(wifi_iface_status status)
+constexpr bool everyPairHandled()
 {
-    if (state)
+    for (const row& r : table)
     {
-        state->handle(*this, status);
+        for (const cell& c : r.on)
+        {
+            if ((c.kind == rule::UNHANDLED) || ((c.kind == rule::GOTO) && (c.target >= WIFI_SM_STATE_COUNT)))
+            {
+                return false;
+            }
+        }
     }
+    return true;
 }
 
-const char * wifiContext::getStateName()
+static_assert(std::size(table) == WIFI_SM_STATE_COUNT, "Wi-Fi state machine: one table row per state");
+static_assert(rowsInStateOrder(), "Wi-Fi state machine: table rows must follow wifiStateEnum order");
+static_assert(everyPairHandled(), "Wi-Fi state machine: every state/event pair needs a transition or ignore");
+
+constexpr const char* event_names[EVENT_COUNT] = {
+    "CONNECT", "DISCONNECT", "CONNECTED", "LINK_LOST", "RETRY", "FAULT", "RECOVER",
+};
+
+bool linkSettled(const wifi_iface_status& status)
 {
-    switch(state->name())
+    return (status.state == WIFI_STATE_INACTIVE) || (status.state == WIFI_STATE_DISCONNECTED);
+}
+
+} // namespace
+
+constexpr wifiContext::stateInfo wifiContext::states[WIFI_SM_STATE_COUNT] = {
+    {IDLE, "IDLE", &wifiContext::enterIdle},
+    {CONNECTING, "CONNECTING", &wifiContext::enterConnecting},
+    {CONNECTED, "CONNECTED", &wifiContext::enterConnected},
+    {DISCONNECTED, "DISCONNECTED", &wifiContext::enterDisconnected},
+    {ERROR, "ERROR", &wifiContext::enterError},
+};
+
+wifiContext::wifiContext() : posted_at{}, trace{}
+{
+    atomic_set(&posted, 0);
+}
+
+void wifiContext::start(net_if* _iface)
+{
+    iface = _iface;
+    state = IDLE;
+    states[IDLE].enter(*this);
+    record(IDLE, IDLE, wifiEvent::NONE, k_cycle_get_32());
+}
+
+bool wifiContext::dispatch(wifiEvent event)
+{
+    return apply(event, k_cycle_get_32());
+}
+
+void wifiContext::post(wifiEvent event)
+{
+    size_t bit = static_cast<size_t>(event);
+
+    posted_at[bit] = k_cycle_get_32();
+    atomic_set_bit(&posted, bit);
+}
+
+bool wifiContext::hasPosted() const
+{
+    return atomic_get(&posted) != 0;
+}
+
+void wifiContext::update(const wifi_iface_status& status)
+{
+    for (size_t bit = 0; bit < EVENT_COUNT; bit++)
+    {
+        wifiEvent event = static_cast<wifiEvent>(bit);
+
+        if (!atomic_test_bit(&posted, bit))
+        {
+            continue;
+        }
+
+        /* Wait for the driver to finish whatever it was doing before connecting */
+        if ((event == wifiEvent::CONNECT) && (state == IDLE) && !linkSettled(status))
+        {
+            continue;
+        }
+
+        atomic_clear_bit(&posted, bit);
+        apply(event, posted_at[bit]);
+    }
+
+    /* Events implied by the interface status, one per update */
+    switch (state)
     {
-        case IDLE:
-            return "IDLE";
         case CONNECTING:
-            return "CONNECTING";
-        case CONNECTED:
-            return "CONNECTED";
-        case DISCONNECTED:
-            return "DISCONNECTED";
+            if ((status.state == WIFI_STATE_COMPLETED) && connect_attempt.hasIp())
+            {
+                dispatch(wifiEvent::CONNECTED);
+            }
+            break;
+
         case ERROR:
-            return "ERROR";
+            dispatch(wifiEvent::RECOVER);
+            break;
+
         default:
-            return "ERROR";
+            break;
     }
 }
 
-wifiStateEnum wifiContext::getState()
+bool wifiContext::apply(wifiEvent event, uint32_t raised_at)
 {
-    return static_cast<wifiStateEnum>(state->name());
-}
\ No newline at end of file
+    bool moved = false;
+
+    /* Entry actions may fail and chain an event (Connecting -> FAULT -> Error) */
+    while (event != wifiEvent::NONE)
+    {
+        const cell& c = table[state].on[static_cast<size_t>(event)];
+
+        if (c.kind != rule::GOTO)
+        {
+            break;
+        }
+
+        wifiStateEnum from = state;
+
+        state = c.target;
+        wifiEvent next = states[state].enter(*this);
+        record(from, state, event, raised_at);
+
+        moved     = true;
+        event     = next;
+        raised_at = k_cycle_get_32();
+    }
+    return moved;
+}
+
+void wifiContext::record(wifiStateEnum from, wifiStateEnum to, wifiEvent event, uint32_t raised_at)
+{
+    transition entry;
+
+    entry.at_ms      = k_uptime_get_32();
+    entry.latency_us = k_cyc_to_us_floor32(k_cycle_get_32() - raised_at);
+    entry.from       = from;
+    entry.to         = to;
+    entry.event      = event;
+
+    k_spinlock_key_t key = k_spin_lock(&trace_lock);
+    trace[trace_count % TRACE_DEPTH] = entry;
+    trace_count++;
+    k_spin_unlock(&trace_lock, key);
+}
+
+size_t wifiContext::getTrace(transition* out, size_t max)
+{
+    k_spinlock_key_t key   = k_spin_lock(&trace_lock);
+    size_t           count = MIN(MIN((size_t)trace_count, TRACE_DEPTH), max);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = trace[(trace_count - 1 - i) % TRACE_DEPTH];
+    }
+    k_spin_unlock(&trace_lock, key);
+
+    return count;
+}
+
+uint32_t wifiContext::getTransitionCount()
+{
+    k_spinlock_key_t key   = k_spin_lock(&trace_lock);
+    uint32_t         count = trace_count;
+    k_spin_unlock(&trace_lock, key);
+
+    return count;
+}
+
+wifiStateEnum wifiContext::getState() const
+{
+    return state;
+}
+
+const char* wifiContext::getStateName() const
+{
+    return stateName(state);
+}
+
+const char* wifiContext::stateName(wifiStateEnum state)
+{
+    return (state < WIFI_SM_STATE_COUNT) ? states[state].name : "ERROR";
+}
+
+const char* wifiContext::eventName(wifiEvent event)
+{
+    return (event < wifiEvent::COUNT) ? event_names[static_cast<size_t>(event)] : "START";
+}
+
+wifiConnectAttempt& wifiContext::attempt()
+{
+    return connect_attempt;
+}
+
+/* Entry actions */
+
+wifiEvent wifiContext::enterIdle(wifiContext& ctx)
+{
+    ARG_UNUSED(ctx);
+    return wifiEvent::NONE;
+}
+
+wifiEvent wifiContext::enterConnecting(wifiContext& ctx)
+{
+    return (ctx.connect_attempt.start(ctx.iface) == 0) ? wifiEvent::NONE : wifiEvent::FAULT;
+}
+
+wifiEvent wifiContext::enterConnected(wifiContext& ctx)
+{
+    ARG_UNUSED(ctx);
+    MYLOG("📶 Connected! Holding...");
+    return wifiEvent::NONE;
+}
+
+wifiEvent wifiContext::enterDisconnected(wifiContext& ctx)
+{
+    ARG_UNUSED(ctx);
+    MYLOG("❌ Disconnected. Awaiting reconnection...");
+    return wifiEvent::NONE;
+}
+
+wifiEvent wifiContext::enterError(wifiContext& ctx)
+{
+    ARG_UNUSED(ctx);
+    MYLOG("🛑 Entered Error state");
+    return wifiEvent::NONE;
+}
@@ -1,7 +1,7 @@
 /*
  * This file is part of the Zephyr Home project.
  *
- * Copyright (C) 2024 Osama Salah-ud-din
+ * Copyright (C) 2025 Osama Salah-ud-Din
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU Affero General Public License as published by
@@ -17,11 +17,12 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #pragma once
-#include "wifiState.hpp"
-#include "myLogger.hpp"
+#include "wifiConnectAttempt.hpp"
 
+#include <zephyr/kernel.h>
 #include <zephyr/net/net_if.h>
 #include <zephyr/net/wifi_mgmt.h>
+#include <zephyr/sys/atomic.h>
 
 typedef enum
 {
@@ -30,18 +31,140 @@ typedef enum
     CONNECTED,
     DISCONNECTED,
     ERROR,
+    WIFI_SM_STATE_COUNT,
 } wifiStateEnum;
 
+/**
+ * @brief Inputs of the Wi-Fi state machine.
+ */
+enum class wifiEvent : uint8_t
+{
+    CONNECT,    /**< Connect requested */
+    DISCONNECT, /**< Disconnect requested and accepted by the driver */
+    CONNECTED,  /**< Interface completed and IPv4 address obtained */
+    LINK_LOST,  /**< Disconnected without a request */
+    RETRY,      /**< Restart the connect attempt (hinted attempt failed) */
+    FAULT,      /**< No interface or a request the driver rejected */
+    RECOVER,    /**< Leave Error */
+    COUNT,
+    NONE = COUNT,
+};
+
+/**
+ * @brief Table-driven Wi-Fi state machine.
+ *
+ * Transitions come from a constexpr table with one entry per state/event pair, checked at
+ * compile time; states are table rows with an entry action, so nothing is allocated.
+ * Every transition is recorded with its latency in a trace ring.
+ *
+ * @note dispatch() and update() run on the owner's thread only. Other threads (net_mgmt
+ *       handlers) use post(); the event is applied by the next update().
+ */
 class wifiContext
 {
-private:
-    wifiState* state;
-    net_if* iface;
-
-public:
-    wifiContext(wifiState* initial, net_if* iface);
-    void setState(wifiState* newState);
-    wifiStateEnum  getState();
-    const char *getStateName();
-    void update(wifi_iface_status status);
+  public:
+    /**
+     * @brief One recorded transition.
+     */
+    struct transition
+    {
+        uint32_t      at_ms;      /**< Uptime of the transition */
+        uint32_t      latency_us; /**< Event raised to entry action done */
+        wifiStateEnum from;
+        wifiStateEnum to;
+        wifiEvent     event;
+    };
+
+    /**
+     * @brief Number of transitions kept in the trace ring
+     */
+    static constexpr size_t TRACE_DEPTH = 16;
+
+    wifiContext();
+
+    /**
+     * @brief Bind the interface and enter Idle.
+     */
+    void start(net_if* iface);
+
+    /**
+     * @brief Apply @p event now.
+     * @return true if the event caused a transition.
+     */
+    bool dispatch(wifiEvent event);
+
+    /**
+     * @brief Queue @p event for the next update(); safe from any thread.
+     */
+    void post(wifiEvent event);
+
+    /**
+     * @brief Whether events are waiting for update().
+     */
+    bool hasPosted() const;
+
+    /**
+     * @brief Apply the posted events, then the event @p status implies for the current state.
+     * @note A posted CONNECT waits in Idle until the interface is inactive or disconnected.
+     */
+    void update(const wifi_iface_status& status);
+
+    wifiStateEnum getState() const;
+    const char*   getStateName() const;
+
+    static const char* stateName(wifiStateEnum state);
+    static const char* eventName(wifiEvent event);
+
+    /**
+     * @brief The connect attempt started by the Connecting state.
+     */
+    wifiConnectAttempt& attempt();
+
+    /**
+     * @brief Copy the trace, newest first.
+     *
+     * @param out Destination, up to TRACE_DEPTH entries.
+     * @param max Capacity of @p out.
+     * @return Number of entries copied.
+     */
+    size_t getTrace(transition* out, size_t max);
+
+    /**
+     * @brief Total transitions since start().
+     */
+    uint32_t getTransitionCount();
+
+  private:
+    using entryAction = wifiEvent (*)(wifiContext& ctx);
+
+    struct stateInfo
+    {
+        wifiStateEnum state;
+        const char*   name;
+        entryAction   enter; /**< Returns a follow-up event, or NONE */
+    };
+
+    static const stateInfo states[WIFI_SM_STATE_COUNT];
+
+    static wifiEvent enterIdle(wifiContext& ctx);
+    static wifiEvent enterConnecting(wifiContext& ctx);
+    static wifiEvent enterConnected(wifiContext& ctx);
+    static wifiEvent enterDisconnected(wifiContext& ctx);
+    static wifiEvent enterError(wifiContext& ctx);
+
+    bool apply(wifiEvent event, uint32_t raised_at);
+    void record(wifiStateEnum from, wifiStateEnum to, wifiEvent event, uint32_t raised_at);
+
+    wifiStateEnum      state = IDLE;
+    net_if*            iface = nullptr;
+    wifiConnectAttempt connect_attempt;
+
+    /* Posted events, one bit per wifiEvent, with the cycle count they were posted at */
+    atomic_t posted;
+    uint32_t posted_at[static_cast<size_t>(wifiEvent::COUNT)];
+
+    /* Trace ring, read by the shell */
+    struct k_spinlock trace_lock;
+    transition        trace[TRACE_DEPTH];
+    uint32_t          trace_count = 0;
 };
@@ -0,0 +1,334 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/ethernet.h>
+#include <zephyr/net/net_if.h>
+#include <zephyr/net/net_pkt.h>
+#include <zephyr/net/wifi_mgmt.h>
+#include <zephyr/shell/shell.h>
+
+#include <app/drivers/fake_wifi.h>
+
+LOG_MODULE_REGISTER(fake_wifi, CONFIG_WIFI_FAKE_LOG_LEVEL);
+
+struct fake_wifi_data {
+	struct net_if *iface;
+	uint8_t mac[6];
+	struct k_work_delayable assoc_work;
+	struct k_work_delayable ip_work;
+	struct k_spinlock lock;
+	enum wifi_iface_state state;
+	uint8_t ssid[WIFI_SSID_MAX_LEN];
+	uint8_t ssid_len;
+	uint32_t fail_next;
+	struct fake_wifi_script script;
+	struct fake_wifi_stats stats;
+	struct in_addr addr;
+	bool addr_set;
+};
+
+/* The simulated AP, locally administered address */
+static const uint8_t fake_ap_bssid[WIFI_MAC_ADDR_LEN] = {0x02, 0x00, 0x5e, 0x00, 0x53, 0xaa};
+
+static struct fake_wifi_data fake_wifi_data = {
+	.mac = {0x02, 0x00, 0x5e, 0x00, 0x53, 0x01},
+	.state = WIFI_STATE_DISCONNECTED,
+	.script = {
+		.scan_ms = CONFIG_WIFI_FAKE_SCAN_MS,
+		.assoc_ms = CONFIG_WIFI_FAKE_ASSOC_MS,
+		.ip_ms = CONFIG_WIFI_FAKE_IP_MS,
+	},
+};
+
+static void fake_wifi_remove_addr(struct fake_wifi_data *data)
+{
+	if (data->addr_set) {
+		net_if_ipv4_addr_rm(data->iface, &data->addr);
+		data->addr_set = false;
+	}
+}
+
+static void fake_wifi_assoc_work(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct fake_wifi_data *data = CONTAINER_OF(dwork, struct fake_wifi_data, assoc_work);
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+	bool fail = (data->fail_next > 0);
+
+	if (fail) {
+		data->fail_next--;
+		data->stats.failures++;
+		data->state = WIFI_STATE_DISCONNECTED;
+	} else {
+		data->state = WIFI_STATE_COMPLETED;
+	}
+	uint32_t ip_ms = data->script.ip_ms;
+
+	k_spin_unlock(&data->lock, key);
+
+	if (fail) {
+		LOG_INF("Connect failed (scripted)");
+		wifi_mgmt_raise_connect_result_event(data->iface, WIFI_STATUS_CONN_FAIL);
+		return;
+	}
+
+	LOG_INF("Associated");
+	net_if_dormant_off(data->iface);
+	wifi_mgmt_raise_connect_result_event(data->iface, WIFI_STATUS_CONN_SUCCESS);
+	k_work_schedule(&data->ip_work, K_MSEC(ip_ms));
+}
+
+static void fake_wifi_ip_work(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct fake_wifi_data *data = CONTAINER_OF(dwork, struct fake_wifi_data, ip_work);
+	struct in_addr netmask = {{{255, 255, 255, 0}}};
+
+	if (net_addr_pton(AF_INET, CONFIG_WIFI_FAKE_IPV4_ADDR, &data->addr) < 0) {
+		LOG_ERR("Invalid CONFIG_WIFI_FAKE_IPV4_ADDR");
+		return;
+	}
+
+	/* Typed as DHCP, like the address a real station would lease */
+	if (net_if_ipv4_addr_add(data->iface, &data->addr, NET_ADDR_DHCP, 0) == NULL) {
+		LOG_ERR("Cannot add the IPv4 address");
+		return;
+	}
+	net_if_ipv4_set_netmask_by_addr(data->iface, &data->addr, &netmask);
+	data->addr_set = true;
+}
+
+static void fake_wifi_link_down(struct fake_wifi_data *data, int status)
+{
+	struct k_work_sync sync;
+
+	k_work_cancel_delayable_sync(&data->assoc_work, &sync);
+	k_work_cancel_delayable_sync(&data->ip_work, &sync);
+
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+
+	data->state = WIFI_STATE_DISCONNECTED;
+	k_spin_unlock(&data->lock, key);
+
+	fake_wifi_remove_addr(data);
+	net_if_dormant_on(data->iface);
+	wifi_mgmt_raise_disconnect_result_event(data->iface, status);
+}
+
+static int fake_wifi_connect(const struct device *dev, struct wifi_connect_req_params *params)
+{
+	struct fake_wifi_data *data = dev->data;
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+
+	if ((data->state != WIFI_STATE_DISCONNECTED) && (data->state != WIFI_STATE_INACTIVE)) {
+		k_spin_unlock(&data->lock, key);
+		return -EALREADY;
+	}
+
+	/* A request aimed at the AP's BSSID and channel skips the scan */
+	bool hinted = (memcmp(params->bssid, fake_ap_bssid, WIFI_MAC_ADDR_LEN) == 0) &&
+		      (params->channel == CONFIG_WIFI_FAKE_CHANNEL);
+	uint32_t delay = data->script.assoc_ms + (hinted ? 0 : data->script.scan_ms);
+
+	data->ssid_len = MIN(params->ssid_length, sizeof(data->ssid));
+	memcpy(data->ssid, params->ssid, data->ssid_len);
+	data->state = hinted ? WIFI_STATE_ASSOCIATING : WIFI_STATE_SCANNING;
+	data->stats.connects++;
+	if (hinted) {
+		data->stats.hinted++;
+	}
+	k_spin_unlock(&data->lock, key);
+
+	LOG_INF("Connect request, %s, result in %u ms", hinted ? "hinted" : "scanning", delay);
+	k_work_schedule(&data->assoc_work, K_MSEC(delay));
+
+	return 0;
+}
+
+static int fake_wifi_disconnect(const struct device *dev)
+{
+	struct fake_wifi_data *data = dev->data;
+
+	fake_wifi_link_down(data, WIFI_REASON_DISCONN_SUCCESS);
+	return 0;
+}
+
+static int fake_wifi_iface_status(const struct device *dev, struct wifi_iface_status *status)
+{
+	struct fake_wifi_data *data = dev->data;
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+
+	memset(status, 0, sizeof(*status));
+	status->state = data->state;
+	status->iface_mode = WIFI_MODE_INFRA;
+
+	if (data->state >= WIFI_STATE_ASSOCIATED) {
+		memcpy(status->ssid, data->ssid, data->ssid_len);
+		status->ssid_len = data->ssid_len;
+		memcpy(status->bssid, fake_ap_bssid, WIFI_MAC_ADDR_LEN);
+		status->band = WIFI_FREQ_BAND_2_4_GHZ;
+		status->channel = CONFIG_WIFI_FAKE_CHANNEL;
+		status->link_mode = WIFI_4;
+		status->security = WIFI_SECURITY_TYPE_PSK;
+		status->rssi = -50;
+	}
+	k_spin_unlock(&data->lock, key);
+
+	return 0;
+}
+
+static int fake_wifi_send(const struct device *dev, struct net_pkt *pkt)
+{
+	/* No peer: frames are dropped, like an AP that forwards nothing */
+	ARG_UNUSED(dev);
+	ARG_UNUSED(pkt);
+	return 0;
+}
+
+static void fake_wifi_iface_init(struct net_if *iface)
+{
+	const struct device *dev = net_if_get_device(iface);
+	struct fake_wifi_data *data = dev->data;
+	struct ethernet_context *eth_ctx = net_if_l2_data(iface);
+
+	eth_ctx->eth_if_type = L2_ETH_IF_TYPE_WIFI;
+	data->iface = iface;
+
+	net_if_set_link_addr(iface, data->mac, sizeof(data->mac), NET_LINK_ETHERNET);
+	ethernet_init(iface);
+	net_if_dormant_on(iface);
+}
+
+static const struct wifi_mgmt_ops fake_wifi_mgmt = {
+	.connect = fake_wifi_connect,
+	.disconnect = fake_wifi_disconnect,
+	.iface_status = fake_wifi_iface_status,
+};
+
+static const struct net_wifi_mgmt_offload fake_wifi_api = {
+	.wifi_iface.iface_api.init = fake_wifi_iface_init,
+	.wifi_iface.send = fake_wifi_send,
+	.wifi_mgmt_api = &fake_wifi_mgmt,
+};
+
+static int fake_wifi_dev_init(const struct device *dev)
+{
+	struct fake_wifi_data *data = dev->data;
+
+	k_work_init_delayable(&data->assoc_work, fake_wifi_assoc_work);
+	k_work_init_delayable(&data->ip_work, fake_wifi_ip_work);
+
+	return 0;
+}
+
+ETH_NET_DEVICE_INIT(fake_wifi, "fake_wifi", fake_wifi_dev_init, NULL, &fake_wifi_data, NULL,
+		    CONFIG_WIFI_INIT_PRIORITY, &fake_wifi_api, NET_ETH_MTU);
+
+void fake_wifi_set_script(const struct fake_wifi_script *script)
+{
+	k_spinlock_key_t key = k_spin_lock(&fake_wifi_data.lock);
+
+	fake_wifi_data.script = *script;
+	k_spin_unlock(&fake_wifi_data.lock, key);
+}
+
+void fake_wifi_fail_next(uint32_t count)
+{
+	k_spinlock_key_t key = k_spin_lock(&fake_wifi_data.lock);
+
+	fake_wifi_data.fail_next = count;
+	k_spin_unlock(&fake_wifi_data.lock, key);
+}
+
+int fake_wifi_drop(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&fake_wifi_data.lock);
+	bool connected = (fake_wifi_data.state == WIFI_STATE_COMPLETED);
+
+	if (connected) {
+		fake_wifi_data.stats.drops++;
+	}
+	k_spin_unlock(&fake_wifi_data.lock, key);
+
+	if (!connected) {
+		return -ENOTCONN;
+	}
+
+	LOG_INF("Dropping the connection (scripted)");
+	fake_wifi_link_down(&fake_wifi_data, WIFI_REASON_DISCONN_AP_LEAVING);
+	return 0;
+}
+
+void fake_wifi_get_stats(struct fake_wifi_stats *stats)
+{
+	k_spinlock_key_t key = k_spin_lock(&fake_wifi_data.lock);
+
+	*stats = fake_wifi_data.stats;
+	k_spin_unlock(&fake_wifi_data.lock, key);
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_fake_wifi_script(const struct shell *sh, size_t argc, char **argv)
+{
+	struct fake_wifi_script script = {
+		.scan_ms = strtoul(argv[1], NULL, 10),
+		.assoc_ms = strtoul(argv[2], NULL, 10),
+		.ip_ms = strtoul(argv[3], NULL, 10),
+	};
+
+	ARG_UNUSED(argc);
+	fake_wifi_set_script(&script);
+	return 0;
+}
+
+static int cmd_fake_wifi_fail(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(sh);
+	ARG_UNUSED(argc);
+	fake_wifi_fail_next(strtoul(argv[1], NULL, 10));
+	return 0;
+}
+
+static int cmd_fake_wifi_drop(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	if (fake_wifi_drop() < 0) {
+		shell_error(sh, "Not connected");
+		return -ENOTCONN;
+	}
+	return 0;
+}
+
+static int cmd_fake_wifi_status(const struct shell *sh, size_t argc, char **argv)
+{
+	struct fake_wifi_stats stats;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	fake_wifi_get_stats(&stats);
+	shell_print(sh, "state: %s", wifi_state_txt(fake_wifi_data.state));
+	shell_print(sh, "script: scan %u ms, assoc %u ms, ip %u ms, failing next %u", fake_wifi_data.script.scan_ms,
+		    fake_wifi_data.script.assoc_ms, fake_wifi_data.script.ip_ms, fake_wifi_data.fail_next);
+	shell_print(sh, "connects %u (hinted %u), failures %u, drops %u", stats.connects, stats.hinted,
+		    stats.failures, stats.drops);
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_fake_wifi,
+	SHELL_CMD_ARG(script, NULL, "<scan_ms> <assoc_ms> <ip_ms>", cmd_fake_wifi_script, 4, 0),
+	SHELL_CMD_ARG(fail, NULL, "<count> fail the next connect requests", cmd_fake_wifi_fail, 2, 0),
+	SHELL_CMD(drop, NULL, "Drop the connection as if the AP went away", cmd_fake_wifi_drop),
+	SHELL_CMD(status, NULL, "Driver state and counters", cmd_fake_wifi_status),
+	SHELL_SUBCMD_SET_END);
+SHELL_CMD_REGISTER(fake_wifi, &sub_fake_wifi, "Fake Wi-Fi driver scripting", NULL);
+#endif
@@ -0,0 +1,87 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef APP_DRIVERS_FAKE_WIFI_H_
+#define APP_DRIVERS_FAKE_WIFI_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup drivers_fake_wifi Fake Wi-Fi driver
+ * @ingroup drivers
+ * @{
+ *
+ * @brief Scripting interface of the fake Wi-Fi driver (CONFIG_WIFI_FAKE).
+ *
+ * The driver behaves like a Wi-Fi station with a single simulated AP. These
+ * calls change how the next connect requests behave, so reconnect timing and
+ * recovery can be measured on native_sim.
+ */
+
+/** @brief Timing of a simulated connect */
+struct fake_wifi_script {
+	/** Scan time, skipped when the request carries the AP's BSSID/channel */
+	uint32_t scan_ms;
+	/** Association time */
+	uint32_t assoc_ms;
+	/** Time from association to the IPv4 address */
+	uint32_t ip_ms;
+};
+
+/** @brief Counters kept by the driver */
+struct fake_wifi_stats {
+	/** Connect requests */
+	uint32_t connects;
+	/** Requests that carried a matching BSSID/channel hint */
+	uint32_t hinted;
+	/** Requests failed on purpose */
+	uint32_t failures;
+	/** Connections dropped on purpose */
+	uint32_t drops;
+};
+
+/**
+ * @brief Set the timing of the following connect requests.
+ *
+ * @param script New timing.
+ */
+void fake_wifi_set_script(const struct fake_wifi_script *script);
+
+/**
+ * @brief Make the next connect requests fail.
+ *
+ * The connect result event reports a failure after the scan and association time.
+ *
+ * @param count Number of requests to fail.
+ */
+void fake_wifi_fail_next(uint32_t count);
+
+/**
+ * @brief Drop the current connection as if the AP went away.
+ *
+ * Raises a disconnect result event with a non-zero status and removes the address.
+ *
+ * @retval 0 if a connection was dropped.
+ * @retval -ENOTCONN if not connected.
+ */
+int fake_wifi_drop(void);
+
+/**
+ * @brief Get the driver counters.
+ *
+ * @param stats Filled with the counters.
+ */
+void fake_wifi_get_stats(struct fake_wifi_stats *stats);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_DRIVERS_FAKE_WIFI_H_ */
@@ -0,0 +1,196 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2025 Osama Salah-ud-Din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @file clock discipline tests
+ *
+ * The model is fed synthetic measurements: local time is whatever the test
+ * says, so slews, steps and oscillator errors are exact and repeatable.
+ */
+
+#include <zephyr/ztest.h>
+
+#include "clockDiscipline.hpp"
+
+/* Some epoch in 2025, in microseconds */
+#define EPOCH_US   1750000000000000LL
+#define MIN_US     ((int64_t)CONFIG_APP_SNTP_MIN_INTERVAL * USEC_PER_SEC)
+
+/* Sample the model every @p step_us over [from, to] and check it never goes back */
+static void assert_monotonic(const clockDiscipline& clock, int64_t from, int64_t to, int64_t step_us)
+{
+    int64_t last = clock.epochUs(from);
+
+    for (int64_t local = from + step_us; local <= to; local += step_us)
+    {
+        int64_t now = clock.epochUs(local);
+
+        zassert_true(now >= last, "time went back %lld us at local %lld", last - now, local);
+        last = now;
+    }
+}
+
+ZTEST(clock_discipline, test_first_sync_steps)
+{
+    clockDiscipline clock;
+
+    zassert_false(clock.isSynced());
+    zassert_equal(clock.epochUs(1000), 0, "unsynced model reported a time");
+
+    zassert_equal(clock.update(EPOCH_US, 5000000), clockDiscipline::correction::STEP);
+    zassert_true(clock.isSynced());
+    zassert_equal(clock.epochUs(5000000), EPOCH_US);
+    zassert_equal(clock.epochUs(6000000), EPOCH_US + 1000000);
+}
+
+ZTEST(clock_discipline, test_slew_back_never_steps_backwards)
+{
+    clockDiscipline clock;
+    int64_t         at = MIN_US;
+
+    clock.update(EPOCH_US, 0);
+
+    /* Server 100 ms behind the model: slewed back, and the frequency estimate goes to its negative limit */
+    int64_t model = clock.epochUs(at);
+    zassert_equal(clock.update(model - 100000, at), clockDiscipline::correction::SLEW);
+    zassert_equal(clock.getStats().freq_ppb, -clockDiscipline::MAX_FREQ_PPB);
+
+    /* Every microsecond around the rebase, then every millisecond until well after the slew ends */
+    assert_monotonic(clock, at - 10000, at + 10 * USEC_PER_SEC, 1);
+    assert_monotonic(clock, at, at + 400 * USEC_PER_SEC, 1000);
+}
+
+ZTEST(clock_discipline, test_slew_forward_continuous)
+{
+    clockDiscipline clock;
+    int64_t         at = MIN_US;
+
+    clock.update(EPOCH_US, 0);
+
+    int64_t model = clock.epochUs(at);
+    zassert_equal(clock.update(model + 100000, at), clockDiscipline::correction::SLEW);
+
+    /* No jump at the measurement: the offset is spread over the following interval */
+    zassert_equal(clock.epochUs(at), model);
+    assert_monotonic(clock, at - 10000, at + 10 * USEC_PER_SEC, 1);
+}
+
+ZTEST(clock_discipline, test_slew_completes)
+{
+    clockDiscipline clock;
+    int64_t         at     = MIN_US;
+    int64_t         offset = 64000;
+
+    clock.update(EPOCH_US, 0);
+    clock.update(EPOCH_US + at + offset, at);
+
+    int32_t freq = clock.getStats().freq_ppb;
+    int64_t done = (offset * 1000000) / clockDiscipline::SLEW_PPM;
+
+    /* Once the slew budget covers the offset, the model runs at the corrected rate from the server time */
+    for (int64_t t = done + USEC_PER_SEC; t < done + 100 * USEC_PER_SEC; t += 7 * USEC_PER_SEC)
+    {
+        int64_t expected = EPOCH_US + at + offset + t + (t * freq) / 1000000000;
+
+        zassert_within(clock.epochUs(at + t), expected, 1, "slew not finished at +%lld us", t);
+    }
+}
+
+ZTEST(clock_discipline, test_large_offset_steps)
+{
+    clockDiscipline clock;
+    int64_t         at = MIN_US;
+
+    clock.update(EPOCH_US, 0);
+    clock.update(EPOCH_US + at + 1000, at);
+
+    int32_t  freq   = clock.getStats().freq_ppb;
+    uint32_t before = clock.getStats().steps;
+
+    at += MIN_US;
+    zassert_equal(clock.update(EPOCH_US + 3600LL * USEC_PER_SEC, at), clockDiscipline::correction::STEP);
+    zassert_equal(clock.epochUs(at), EPOCH_US + 3600LL * USEC_PER_SEC);
+    zassert_equal(clock.getStats().steps, before + 1);
+    zassert_equal(clock.getStats().freq_ppb, freq, "a step discarded the frequency estimate");
+    zassert_equal(clock.nextIntervalMs(), CONFIG_APP_SNTP_MIN_INTERVAL * MSEC_PER_SEC);
+}
+
+ZTEST(clock_discipline, test_frequency_estimate)
+{
+    /* Local oscillator 40 ppm slow: the server gains 40 us per second of local time */
+    const int64_t   error_ppb = 40000;
+    clockDiscipline clock;
+    int64_t         local = 0;
+
+    clock.update(EPOCH_US, local);
+    for (int i = 0; i < 24; i++)
+    {
+        local += (int64_t)clock.nextIntervalMs() * USEC_PER_MSEC;
+        clock.update(EPOCH_US + local + (local * error_ppb) / 1000000000, local);
+    }
+
+    clockDiscipline::stats stats = clock.getStats();
+
+    zassert_within(stats.freq_ppb, error_ppb, 1000, "estimate %d ppb", stats.freq_ppb);
+    zassert_within(stats.offset_us, 0, clockDiscipline::STABLE_OFFSET_US, "offset %lld us", stats.offset_us);
+    zassert_true(stats.interval_s > CONFIG_APP_SNTP_MIN_INTERVAL, "interval never grew");
+    zassert_equal(stats.steps, 1, "a sync stepped the clock");
+}
+
+ZTEST(clock_discipline, test_long_holdover)
+{
+    clockDiscipline clock;
+    int64_t         at = MIN_US;
+
+    clock.update(EPOCH_US, 0);
+
+    /* Frequency at its negative limit and a slew in progress, then 400 days without a sync */
+    int64_t model = clock.epochUs(at);
+    clock.update(model - 100000, at);
+    zassert_equal(clock.getStats().freq_ppb, -clockDiscipline::MAX_FREQ_PPB);
+
+    int64_t seconds = 400LL * 24 * 3600;
+    int64_t t       = seconds * USEC_PER_SEC;
+
+    /* -500000 ppb loses exactly 500 us per second, and the slew is long done */
+    int64_t expected = model + t - 100000 - (seconds * 500);
+
+    zassert_equal(clock.epochUs(at + t), expected, "off by %lld us", clock.epochUs(at + t) - expected);
+    assert_monotonic(clock, at + t - USEC_PER_SEC, at + t + USEC_PER_SEC, 1000);
+}
+
+ZTEST(clock_discipline, test_failure_shortens_interval)
+{
+    clockDiscipline clock;
+    int64_t         local = 0;
+
+    clock.update(EPOCH_US, local);
+    for (int i = 0; i < 6; i++)
+    {
+        local += (int64_t)clock.nextIntervalMs() * USEC_PER_MSEC;
+        clock.update(EPOCH_US + local, local);
+    }
+    zassert_true(clock.nextIntervalMs() > CONFIG_APP_SNTP_MIN_INTERVAL * MSEC_PER_SEC);
+
+    clock.onFailure();
+    zassert_equal(clock.nextIntervalMs(), CONFIG_APP_SNTP_MIN_INTERVAL * MSEC_PER_SEC);
+    zassert_true(clock.isSynced(), "a failed sync dropped the time");
+}
+
+ZTEST_SUITE(clock_discipline, NULL, NULL, NULL, NULL, NULL);
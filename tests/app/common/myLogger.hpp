@@ -1,34 +1,28 @@
-/*
- * This file is part of the Zephyr Home project.
- *
- * Copyright (C) 2024 Osama Salah-ud-din
- *
- * This program is free software: you can redistribute it and/or modify
- * it under the terms of the GNU Affero General Public License as published by
- * the Free Software Foundation, either version 3 of the License, or
- * (at your option) any later version.
- *
- * This program is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU Affero General Public License for more details.
- *
- * You should have received a copy of the GNU Affero General Public License
- * along with this program.  If not, see <https://www.gnu.org/licenses/>.
- */
-
-#pragma once
-
-#include <zephyr/net/net_if.h>
-#include <zephyr/net/wifi_mgmt.h>
-
-class wifiContext;  // Forward declaration
-
-class wifiState
-{
-public:
-    virtual void enter(wifiContext& ctx, net_if* iface) = 0;
-    virtual void handle(wifiContext& ctx, wifi_iface_status status) = 0;
-    virtual int name() const = 0;
-    virtual ~wifiState() = default;
-};
\ No newline at end of file
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2025 Osama Salah-ud-Din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <zephyr/sys/printk.h>
+
+/*
+    Stand-in for the application logger in unit tests: the real one
+    needs the network stack and the time manager
+*/
+#define MYLOG(fmt, ...) printk(fmt "\n", ##__VA_ARGS__)
@@ -0,0 +1,139 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2025 Osama Salah-ud-Din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @file reconnect policy tests
+ *
+ * Backoff growth, cap and reset, and the circuit breaker trip, half-open
+ * probing and close, with the limits from prj.conf.
+ */
+
+#include <zephyr/ztest.h>
+
+#include "reconnectPolicy.hpp"
+
+/* backoffReconnectPolicy::BASE_MS */
+#define BASE_MS  2000U
+#define CAP_MS   (CONFIG_APP_RECONNECT_MAX_DELAY * 1000U)
+#define COOL_MS  (CONFIG_APP_RECONNECT_BREAKER_COOLDOWN * 1000U)
+#define SAMPLES  32
+
+/* Every delay is jittered into [delay / 2, delay] */
+static void assert_jittered(reconnectPolicy& policy, uint32_t delay)
+{
+    for (int i = 0; i < SAMPLES; i++)
+    {
+        uint32_t got = policy.nextDelay();
+        zassert_between_inclusive(got, delay / 2, delay, "delay %u outside [%u, %u]", got, delay / 2, delay);
+    }
+}
+
+ZTEST(reconnect_policy, test_backoff_doubles_per_failure)
+{
+    backoffReconnectPolicy policy;
+
+    for (uint32_t failures = 0; (BASE_MS << failures) < CAP_MS; failures++)
+    {
+        assert_jittered(policy, BASE_MS << failures);
+        policy.onFailure(100);
+    }
+}
+
+ZTEST(reconnect_policy, test_backoff_capped)
+{
+    backoffReconnectPolicy policy;
+
+    for (int i = 0; i < 40; i++)
+    {
+        policy.onFailure(100);
+    }
+    assert_jittered(policy, CAP_MS);
+}
+
+ZTEST(reconnect_policy, test_backoff_reset_by_success)
+{
+    backoffReconnectPolicy policy;
+
+    for (int i = 0; i < 5; i++)
+    {
+        policy.onFailure(100);
+    }
+    policy.onSuccess(250);
+    assert_jittered(policy, BASE_MS);
+
+    reconnectPolicy::stats stats = policy.getStats();
+    zassert_equal(stats.attempts, 6);
+    zassert_equal(stats.failures, 5);
+    zassert_equal(stats.successes, 1);
+    zassert_equal(stats.consecutive_failures, 0);
+    zassert_equal(stats.attempt_ms_max, 250);
+    zassert_equal(stats.attempt_ms_sum, 750);
+}
+
+ZTEST(reconnect_policy, test_breaker_trips_at_threshold)
+{
+    circuitBreakerReconnectPolicy policy;
+
+    for (int i = 0; i < CONFIG_APP_RECONNECT_BREAKER_THRESHOLD - 1; i++)
+    {
+        policy.onFailure(100);
+    }
+    zassert_equal(policy.getStats().trips, 0, "breaker opened early");
+    assert_jittered(policy, MIN(BASE_MS << (CONFIG_APP_RECONNECT_BREAKER_THRESHOLD - 1), CAP_MS));
+
+    policy.onFailure(100);
+    zassert_equal(policy.getStats().trips, 1, "breaker did not open");
+
+    /* Half-open: one probe per cooldown instead of the backoff */
+    assert_jittered(policy, COOL_MS);
+}
+
+ZTEST(reconnect_policy, test_breaker_failed_probe_stays_open)
+{
+    circuitBreakerReconnectPolicy policy;
+
+    for (int i = 0; i < CONFIG_APP_RECONNECT_BREAKER_THRESHOLD + 4; i++)
+    {
+        policy.onFailure(100);
+    }
+    zassert_equal(policy.getStats().trips, 1, "an open breaker tripped again");
+    assert_jittered(policy, COOL_MS);
+}
+
+ZTEST(reconnect_policy, test_breaker_closed_by_success)
+{
+    circuitBreakerReconnectPolicy policy;
+
+    for (int i = 0; i < CONFIG_APP_RECONNECT_BREAKER_THRESHOLD; i++)
+    {
+        policy.onFailure(100);
+    }
+    policy.onSuccess(100);
+    assert_jittered(policy, BASE_MS);
+
+    /* Closed again: it takes a full threshold of failures to trip a second time */
+    for (int i = 0; i < CONFIG_APP_RECONNECT_BREAKER_THRESHOLD; i++)
+    {
+        policy.onFailure(100);
+    }
+    zassert_equal(policy.getStats().trips, 2);
+    assert_jittered(policy, COOL_MS);
+}
+
+ZTEST_SUITE(reconnect_policy, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,139 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2025 Osama Salah-ud-Din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @file SNTP server selection tests
+ *
+ * Each test is one sync round of synthetic answers: offsets and error bounds
+ * are chosen so the intersection, or the lack of a majority, is known.
+ */
+
+#include <zephyr/ztest.h>
+
+#include "sntpSelection.hpp"
+
+/* A server that answered the last 8 requests, or only the last one */
+#define REACH_FULL (0xFF)
+#define REACH_NEW  (0x01)
+
+static sntpSelection::sample answer(int64_t offset_us, uint32_t distance_us, uint8_t reach, uint32_t rtt_us)
+{
+    /* Stale flag from an earlier round, select() must clear it */
+    return {offset_us, distance_us, reach, rtt_us, true};
+}
+
+static size_t count_falsetickers(const sntpSelection::sample* samples, size_t count)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        n += samples[i].falseticker ? 1 : 0;
+    }
+    return n;
+}
+
+ZTEST(sntp_selection, test_single_answer)
+{
+    sntpSelection::sample samples[] = {answer(5000, 1000, REACH_NEW, 20000)};
+
+    zassert_equal(sntpSelection::select(samples, 1), 0);
+    zassert_false(samples[0].falseticker);
+}
+
+ZTEST(sntp_selection, test_agreeing_prefers_reach)
+{
+    sntpSelection::sample samples[] = {
+        answer(1000, 4000, REACH_NEW, 5000),
+        answer(1500, 4000, REACH_FULL, 30000),
+        answer(800, 4000, 0x0F, 10000),
+    };
+
+    zassert_equal(sntpSelection::select(samples, 3), 1, "most reachable server wins over the fastest");
+    zassert_equal(count_falsetickers(samples, 3), 0);
+}
+
+ZTEST(sntp_selection, test_equal_reach_prefers_rtt)
+{
+    sntpSelection::sample samples[] = {
+        answer(1000, 4000, REACH_FULL, 30000),
+        answer(1500, 4000, REACH_FULL, 8000),
+        answer(800, 4000, REACH_FULL, 12000),
+    };
+
+    zassert_equal(sntpSelection::select(samples, 3), 1);
+}
+
+ZTEST(sntp_selection, test_falseticker_rejected)
+{
+    /* The outlier is the best server on paper: it must still lose */
+    sntpSelection::sample samples[] = {
+        answer(1000, 2000, REACH_NEW, 30000),
+        answer(900000, 2000, REACH_FULL, 1000),
+        answer(1500, 2000, 0x03, 25000),
+    };
+
+    size_t selected = sntpSelection::select(samples, 3);
+
+    zassert_true(samples[1].falseticker);
+    zassert_equal(count_falsetickers(samples, 3), 1);
+    zassert_equal(selected, 2);
+}
+
+ZTEST(sntp_selection, test_intersection_of_overlapping_bounds)
+{
+    /* Three intervals share [2000, 3000]; the fourth overlaps only one of them */
+    sntpSelection::sample samples[] = {
+        answer(0, 3000, REACH_FULL, 10000),
+        answer(4000, 2000, REACH_FULL, 10000),
+        answer(2500, 500, REACH_FULL, 10000),
+        answer(-6000, 3500, REACH_FULL, 1000),
+    };
+
+    size_t selected = sntpSelection::select(samples, 4);
+
+    zassert_false(samples[0].falseticker);
+    zassert_false(samples[1].falseticker);
+    zassert_false(samples[2].falseticker);
+    zassert_true(samples[3].falseticker);
+    zassert_not_equal(selected, 3);
+}
+
+ZTEST(sntp_selection, test_no_majority_takes_median)
+{
+    /* Two answers that disagree: neither can be called wrong */
+    sntpSelection::sample pair[] = {
+        answer(50000, 1000, REACH_FULL, 1000),
+        answer(-50000, 1000, REACH_NEW, 9000),
+    };
+
+    zassert_equal(sntpSelection::select(pair, 2), 1, "lower median of two");
+    zassert_equal(count_falsetickers(pair, 2), 0);
+
+    /* Three scattered answers: the central one */
+    sntpSelection::sample scattered[] = {
+        answer(90000, 1000, REACH_FULL, 1000),
+        answer(-40000, 1000, REACH_FULL, 1000),
+        answer(10000, 1000, REACH_NEW, 50000),
+    };
+
+    zassert_equal(sntpSelection::select(scattered, 3), 2);
+    zassert_equal(count_falsetickers(scattered, 3), 0);
+}
+
+ZTEST_SUITE(sntp_selection, NULL, NULL, NULL, NULL, NULL);
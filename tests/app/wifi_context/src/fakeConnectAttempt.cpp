@@ -0,0 +1,80 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2025 Osama Salah-ud-Din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Scripted stand-in for wifiConnectAttempt: start() returns fake_connect_result
+ * instead of sending NET_REQUEST_WIFI_CONNECT.
+ */
+
+#include "wifiConnectAttempt.hpp"
+
+int fake_connect_result = 0;
+
+wifiConnectAttempt::wifiConnectAttempt()
+{
+    atomic_set(&associated_at, 0);
+    atomic_set(&ip_at, 0);
+}
+
+int wifiConnectAttempt::start(struct net_if* iface)
+{
+    ARG_UNUSED(iface);
+
+    started_at = k_uptime_get_32();
+    hinted     = hints.valid;
+    atomic_set(&associated_at, 0);
+    atomic_set(&ip_at, 0);
+    return fake_connect_result;
+}
+
+bool wifiConnectAttempt::hasIp() const
+{
+    return atomic_get(&ip_at) != 0;
+}
+
+void wifiConnectAttempt::setAssociated()
+{
+    atomic_set(&associated_at, 1);
+}
+
+void wifiConnectAttempt::setIpObtained()
+{
+    atomic_set(&ip_at, 1);
+}
+
+void wifiConnectAttempt::setHints(const wifi_iface_status& status)
+{
+    ARG_UNUSED(status);
+    hints.valid = true;
+}
+
+void wifiConnectAttempt::clearHints()
+{
+    hints.valid = false;
+}
+
+bool wifiConnectAttempt::isHinted() const
+{
+    return hinted;
+}
+
+wifiConnectAttempt::connectTiming wifiConnectAttempt::getTiming()
+{
+    return {0, 0, hinted};
+}
@@ -0,0 +1,193 @@
+/*
+ * This file is part of the Zephyr Home project.
+ *
+ * Copyright (C) 2025 Osama Salah-ud-Din
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @file Wi-Fi state machine tests
+ *
+ * Every state/event pair of the transition table, entry action failures
+ * chaining into Error, the posted-event rules of update() and the trace ring.
+ */
+
+#include <errno.h>
+
+#include <zephyr/ztest.h>
+
+#include "wifiContext.hpp"
+
+extern int fake_connect_result;
+
+#define EVENTS static_cast<size_t>(wifiEvent::COUNT)
+
+/* Expected target per state and event, wifiStateEnum order; -1 means ignored */
+static const int expected[WIFI_SM_STATE_COUNT][EVENTS] = {
+    /*               CONNECT       DISCONNECT    CONNECTED  LINK_LOST  RETRY       FAULT  RECOVER */
+    /* IDLE */      {CONNECTING,   DISCONNECTED, -1,        ERROR,     -1,         ERROR, -1},
+    /* CONNECTING */{-1,           DISCONNECTED, CONNECTED, ERROR,     CONNECTING, ERROR, -1},
+    /* CONNECTED */ {-1,           DISCONNECTED, -1,        ERROR,     -1,         ERROR, -1},
+    /* DISCONN. */  {CONNECTING,   -1,           -1,        -1,        -1,         ERROR, -1},
+    /* ERROR */     {ERROR,        DISCONNECTED, -1,        -1,        -1,         -1,    DISCONNECTED},
+};
+
+static wifi_iface_status status_in(enum wifi_iface_state state)
+{
+    wifi_iface_status status = {};
+
+    status.state = state;
+    return status;
+}
+
+/* Drive a started context into @p state through the table */
+static void enter(wifiContext& ctx, wifiStateEnum state)
+{
+    ctx.start(nullptr);
+
+    switch (state)
+    {
+        case CONNECTING:
+            ctx.dispatch(wifiEvent::CONNECT);
+            break;
+        case CONNECTED:
+            ctx.dispatch(wifiEvent::CONNECT);
+            ctx.dispatch(wifiEvent::CONNECTED);
+            break;
+        case DISCONNECTED:
+            ctx.dispatch(wifiEvent::DISCONNECT);
+            break;
+        case ERROR:
+            ctx.dispatch(wifiEvent::FAULT);
+            break;
+        default:
+            break;
+    }
+    zassert_equal(ctx.getState(), state, "could not enter %s", wifiContext::stateName(state));
+}
+
+static void before(void* fixture)
+{
+    ARG_UNUSED(fixture);
+    fake_connect_result = 0;
+}
+
+ZTEST(wifi_context, test_transition_table)
+{
+    for (size_t s = 0; s < WIFI_SM_STATE_COUNT; s++)
+    {
+        for (size_t e = 0; e < EVENTS; e++)
+        {
+            wifiContext   ctx;
+            wifiStateEnum from  = static_cast<wifiStateEnum>(s);
+            wifiEvent     event = static_cast<wifiEvent>(e);
+
+            enter(ctx, from);
+            bool moved = ctx.dispatch(event);
+
+            if (expected[s][e] < 0)
+            {
+                zassert_false(moved, "%s on %s moved", wifiContext::stateName(from), wifiContext::eventName(event));
+                zassert_equal(ctx.getState(), from);
+            }
+            else
+            {
+                zassert_true(moved, "%s on %s ignored", wifiContext::stateName(from), wifiContext::eventName(event));
+                zassert_equal(ctx.getState(), expected[s][e], "%s on %s went to %s", wifiContext::stateName(from),
+                              wifiContext::eventName(event), ctx.getStateName());
+            }
+        }
+    }
+}
+
+ZTEST(wifi_context, test_rejected_connect_chains_to_error)
+{
+    wifiContext             ctx;
+    wifiContext::transition trace[2];
+
+    fake_connect_result = -EIO;
+    ctx.start(nullptr);
+
+    zassert_true(ctx.dispatch(wifiEvent::CONNECT));
+    zassert_equal(ctx.getState(), ERROR, "entry failure did not raise FAULT");
+
+    /* Newest first: Connecting -> Error on FAULT, then Idle -> Connecting on CONNECT */
+    zassert_equal(ctx.getTrace(trace, ARRAY_SIZE(trace)), 2);
+    zassert_equal(trace[0].from, CONNECTING);
+    zassert_equal(trace[0].to, ERROR);
+    zassert_equal(trace[0].event, wifiEvent::FAULT);
+    zassert_equal(trace[1].from, IDLE);
+    zassert_equal(trace[1].to, CONNECTING);
+    zassert_equal(trace[1].event, wifiEvent::CONNECT);
+}
+
+ZTEST(wifi_context, test_posted_connect_waits_for_settled_link)
+{
+    wifiContext ctx;
+
+    ctx.start(nullptr);
+    ctx.post(wifiEvent::CONNECT);
+    zassert_true(ctx.hasPosted());
+
+    ctx.update(status_in(WIFI_STATE_SCANNING));
+    zassert_equal(ctx.getState(), IDLE, "connected while the driver was busy");
+    zassert_true(ctx.hasPosted(), "posted CONNECT was dropped");
+
+    ctx.update(status_in(WIFI_STATE_INACTIVE));
+    zassert_equal(ctx.getState(), CONNECTING);
+    zassert_false(ctx.hasPosted());
+}
+
+ZTEST(wifi_context, test_update_implied_events)
+{
+    wifiContext ctx;
+
+    enter(ctx, CONNECTING);
+
+    /* Associated but no address yet */
+    ctx.update(status_in(WIFI_STATE_COMPLETED));
+    zassert_equal(ctx.getState(), CONNECTING);
+
+    ctx.attempt().setIpObtained();
+    ctx.update(status_in(WIFI_STATE_COMPLETED));
+    zassert_equal(ctx.getState(), CONNECTED);
+
+    /* Error recovers to Disconnected on the next update */
+    ctx.dispatch(wifiEvent::LINK_LOST);
+    zassert_equal(ctx.getState(), ERROR);
+    ctx.update(status_in(WIFI_STATE_DISCONNECTED));
+    zassert_equal(ctx.getState(), DISCONNECTED);
+}
+
+ZTEST(wifi_context, test_trace_ring_keeps_newest)
+{
+    wifiContext             ctx;
+    wifiContext::transition trace[wifiContext::TRACE_DEPTH];
+
+    ctx.start(nullptr);
+    for (size_t i = 0; i < wifiContext::TRACE_DEPTH; i++)
+    {
+        ctx.dispatch(wifiEvent::CONNECT);
+        ctx.dispatch(wifiEvent::DISCONNECT);
+    }
+
+    /* start() records one entry, then two per loop */
+    zassert_equal(ctx.getTransitionCount(), 1 + (2 * wifiContext::TRACE_DEPTH));
+    zassert_equal(ctx.getTrace(trace, ARRAY_SIZE(trace)), wifiContext::TRACE_DEPTH);
+    zassert_equal(trace[0].to, DISCONNECTED);
+    zassert_equal(trace[1].to, CONNECTING);
+}
+
+ZTEST_SUITE(wifi_context, NULL, NULL, before, NULL, NULL);